@@ -0,0 +1,260 @@
+#pragma once
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifndef FILEBUFFER_HDR
+#define FILEBUFFER_HDR
+
+//
+// Owns the bytes backing a loaded resource.
+// Files are memory mapped where possible (POSIX), so the resource classes can point straight into the page cache.
+// Everything else (built data, platforms without mmap) lives on the heap.
+// It can also just borrow memory owned by someone else, e.g. a decompressed buffer.
+//
+class FileBuffer
+{
+public:
+	enum Storage
+	{
+		STORAGE_NONE,
+		STORAGE_HEAP,
+		STORAGE_MAPPED,
+		STORAGE_BORROWED
+	};
+
+private:
+	uint8_t* ptr;
+	uintmax_t len;
+	Storage storage;
+
+	void openHeap(std::filesystem::path filename)
+	{
+		std::ifstream ifile;
+		ifile.open(filename, std::ios::binary);
+		if (!ifile.is_open())
+		{
+			throw std::runtime_error(strerror(errno));
+		}
+
+		uintmax_t filesize = std::filesystem::file_size(filename);
+
+		allocate(filesize);
+		ifile.read((char*)ptr, filesize);
+		ifile.close();
+	}
+
+#ifndef _WIN32
+	//
+	// Reads an open file up to its end onto the heap. Pipes and other special files have no size up front,
+	// so the buffer grows as needed (sizeHint is just where it starts).
+	//
+	void readHeap(int fd, uintmax_t sizeHint)
+	{
+		const size_t minGrowth = 64 * 1024;
+
+		// one spare byte, so a correct hint ends with a short read instead of a full one
+		size_t capacity = sizeHint ? (sizeHint + 1) : minGrowth;
+		uint8_t* buf = (uint8_t*)malloc(capacity);
+		if (buf == nullptr)
+			throw std::bad_alloc();
+
+		size_t used = 0;
+		while (true)
+		{
+			if (used == capacity)
+			{
+				size_t newCapacity = capacity + ((capacity / 2 > minGrowth) ? (capacity / 2) : minGrowth);
+				uint8_t* grown = (uint8_t*)realloc(buf, newCapacity);
+				if (grown == nullptr)
+				{
+					free(buf);
+					throw std::bad_alloc();
+				}
+
+				buf = grown;
+				capacity = newCapacity;
+			}
+
+			ssize_t got = read(fd, buf + used, capacity - used);
+			if (got < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				int err = errno;
+				free(buf);
+				throw std::runtime_error(strerror(err));
+			}
+
+			if (got == 0)
+				break;
+
+			used += got;
+		}
+
+		release();
+		ptr = buf;
+		len = used;
+		storage = STORAGE_HEAP;
+	}
+#endif
+
+public:
+	uint8_t* data()
+	{
+		return ptr;
+	}
+
+	uintmax_t size()
+	{
+		return len;
+	}
+
+	Storage type()
+	{
+		return storage;
+	}
+
+	bool mapped()
+	{
+		return storage == STORAGE_MAPPED;
+	}
+
+	//
+	// Frees or unmaps the current contents
+	//
+	void release()
+	{
+		if (storage == STORAGE_HEAP)
+		{
+			if (ptr)
+				free(ptr);
+		}
+#ifndef _WIN32
+		else if (storage == STORAGE_MAPPED)
+		{
+			munmap(ptr, len);
+		}
+#endif
+
+		ptr = nullptr;
+		len = 0;
+		storage = STORAGE_NONE;
+	}
+
+	//
+	// Allocates an uninitialized heap buffer
+	//
+	uint8_t* allocate(uintmax_t size)
+	{
+		release();
+
+		// always hand out a valid pointer, even for empty files
+		ptr = (uint8_t*)malloc(size ? size : 1);
+		if (ptr == nullptr)
+			throw std::bad_alloc();
+
+		len = size;
+		storage = STORAGE_HEAP;
+
+		return ptr;
+	}
+
+	//
+	// Points at memory owned by the caller, which has to outlive this buffer (or the next release)
+	//
+	void borrow(uint8_t* data, uintmax_t size)
+	{
+		release();
+
+		ptr = data;
+		len = size;
+		storage = STORAGE_BORROWED;
+	}
+
+	//
+	// Loads a file. Maps it privately (copy-on-write) where supported, otherwise reads it onto the heap.
+	//
+	void openFile(std::filesystem::path filename)
+	{
+		release();
+
+#ifndef _WIN32
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			throw std::runtime_error(strerror(errno));
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) < 0)
+		{
+			int err = errno;
+			close(fd);
+			throw std::runtime_error(strerror(err));
+		}
+
+		// mmap can't map empty or special files, those are read from the same descriptor
+		if ((st.st_size > 0) && S_ISREG(st.st_mode))
+		{
+			void* map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (map != MAP_FAILED)
+			{
+				close(fd);
+
+				// the whole file is going to be walked front to back
+				madvise(map, st.st_size, MADV_WILLNEED);
+
+				ptr = (uint8_t*)map;
+				len = st.st_size;
+				storage = STORAGE_MAPPED;
+				return;
+			}
+		}
+
+		try
+		{
+			readHeap(fd, S_ISREG(st.st_mode) ? st.st_size : 0);
+		}
+		catch (...)
+		{
+			close(fd);
+			throw;
+		}
+
+		close(fd);
+#else
+		openHeap(filename);
+#endif
+	}
+
+	FileBuffer()
+	{
+		ptr = nullptr;
+		len = 0;
+		storage = STORAGE_NONE;
+	}
+
+	FileBuffer(const FileBuffer&) = delete;
+	FileBuffer& operator=(const FileBuffer&) = delete;
+
+	~FileBuffer()
+	{
+		release();
+	}
+};
+
+#endif
@@ -0,0 +1,324 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <stdexcept>
+#include "FolderCache.hpp"
+#include "FileBuffer.hpp"
+
+namespace FolderCache
+{
+    static constexpr const char* CACHE_HEADER = "tfstring-cache 1";
+
+    static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+    static inline uint64_t rotl64(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // the data is read as little endian, like everything else in this tool
+    static inline uint64_t read64(const uint8_t* p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static inline uint32_t read32(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static inline uint64_t round64(uint64_t acc, uint64_t input)
+    {
+        acc += input * PRIME64_2;
+        acc = rotl64(acc, 31);
+        return acc * PRIME64_1;
+    }
+
+    static inline uint64_t mergeRound64(uint64_t acc, uint64_t val)
+    {
+        acc ^= round64(0, val);
+        return acc * PRIME64_1 + PRIME64_4;
+    }
+
+    uint64_t Hash64(const void* data, size_t size, uint64_t seed)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        uint64_t h;
+
+        if (size >= 32)
+        {
+            uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+            uint64_t v2 = seed + PRIME64_2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - PRIME64_1;
+
+            const uint8_t* limit = end - 32;
+            do
+            {
+                v1 = round64(v1, read64(p));
+                v2 = round64(v2, read64(p + 8));
+                v3 = round64(v3, read64(p + 16));
+                v4 = round64(v4, read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+
+            h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+            h = mergeRound64(h, v1);
+            h = mergeRound64(h, v2);
+            h = mergeRound64(h, v3);
+            h = mergeRound64(h, v4);
+        }
+        else
+        {
+            h = seed + PRIME64_5;
+        }
+
+        h += (uint64_t)size;
+
+        while ((end - p) >= 8)
+        {
+            h ^= round64(0, read64(p));
+            h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+            p += 8;
+        }
+
+        if ((end - p) >= 4)
+        {
+            h ^= (uint64_t)read32(p) * PRIME64_1;
+            h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+            p += 4;
+        }
+
+        while (p < end)
+        {
+            h ^= (*p) * PRIME64_5;
+            h = rotl64(h, 11) * PRIME64_1;
+            p++;
+        }
+
+        h ^= h >> 33;
+        h *= PRIME64_2;
+        h ^= h >> 29;
+        h *= PRIME64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    uint64_t HashFile(const std::filesystem::path& path, uintmax_t& size)
+    {
+        FileBuffer file;
+        file.openFile(path);
+
+        size = file.size();
+        return Hash64(file.data(), file.size());
+    }
+
+    uint64_t HashInputs(const std::vector<std::filesystem::path>& inputs)
+    {
+        std::vector<uint64_t> parts;
+        for (const auto& path : inputs)
+        {
+            std::u8string name = path.filename().u8string();
+            uintmax_t size = 0;
+
+            parts.push_back(Hash64(name.data(), name.size()));
+            parts.push_back(HashFile(path, size));
+            parts.push_back(size);
+        }
+
+        return Hash64(parts.data(), parts.size() * sizeof(uint64_t));
+    }
+
+    static void splitFields(const std::string& line, std::vector<std::string>& fields)
+    {
+        fields.clear();
+        size_t start = 0;
+        while (true)
+        {
+            size_t tab = line.find('\t', start);
+            fields.push_back(line.substr(start, tab - start));
+            if (tab == std::string::npos)
+                break;
+            start = tab + 1;
+        }
+    }
+
+    static bool parseHex(const std::string& str, uint64_t& out)
+    {
+        char* end = nullptr;
+        out = strtoull(str.c_str(), &end, 16);
+        return !str.empty() && (*end == '\0');
+    }
+
+    Cache::Cache(const std::filesystem::path& outputFolder) : outFolder(outputFolder)
+    {
+        std::ifstream file(outFolder / FILE_NAME, std::ios::binary);
+        if (!file.is_open())
+            return;
+
+        std::string line;
+        if (!std::getline(file, line) || (line != CACHE_HEADER))
+            return;
+
+        //
+        // one conversion per line, tab separated:
+        // <key> <settings> <input hash> then <name> <size> <hash> for every output
+        //
+        std::vector<std::string> fields;
+        while (std::getline(file, line))
+        {
+            splitFields(line, fields);
+            if ((fields.size() < 6) || (((fields.size() - 3) % 3) != 0))
+                continue;
+
+            Entry entry;
+            entry.settings = fields[1];
+            bool bValid = parseHex(fields[2], entry.inputHash);
+
+            for (size_t i = 3; bValid && (i < fields.size()); i += 3)
+            {
+                OutputFile out;
+                uint64_t size = 0;
+                out.name = std::u8string(fields[i].begin(), fields[i].end());
+                bValid = parseHex(fields[i + 1], size) && parseHex(fields[i + 2], out.hash);
+                out.size = size;
+                entry.outputs.push_back(std::move(out));
+            }
+
+            if (bValid)
+                previous[std::u8string(fields[0].begin(), fields[0].end())] = std::move(entry);
+        }
+    }
+
+    bool Cache::isUpToDate(const std::u8string& key, const std::string& settings, uint64_t inputHash)
+    {
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = previous.find(key);
+            if (it == previous.end())
+                return false;
+            entry = it->second;
+        }
+
+        if ((entry.settings != settings) || (entry.inputHash != inputHash))
+            return false;
+
+        // someone might have touched the outputs since
+        for (const OutputFile& out : entry.outputs)
+        {
+            std::filesystem::path outPath = outFolder / out.name;
+            std::error_code ec;
+            if (std::filesystem::file_size(outPath, ec) != out.size)
+                return false;
+
+            try
+            {
+                uintmax_t size = 0;
+                if (HashFile(outPath, size) != out.hash)
+                    return false;
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        current[key] = std::move(entry);
+        return true;
+    }
+
+    void Cache::store(const std::u8string& key, const std::string& settings, uint64_t inputHash, const std::vector<std::filesystem::path>& outputs)
+    {
+        Entry entry;
+        entry.settings = settings;
+        entry.inputHash = inputHash;
+
+        try
+        {
+            for (const auto& path : outputs)
+            {
+                OutputFile out;
+                out.name = path.filename().u8string();
+                out.hash = HashFile(path, out.size);
+                entry.outputs.push_back(std::move(out));
+            }
+        }
+        catch (const std::exception&)
+        {
+            // not cached, it just gets converted again next time
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        current[key] = std::move(entry);
+    }
+
+    void Cache::save()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        std::string text = CACHE_HEADER;
+        text += '\n';
+
+        auto isPlain = [](const std::u8string& str)
+        {
+            return str.find_first_of(u8"\t\r\n") == std::u8string::npos;
+        };
+
+        char buf[64];
+        for (const auto& [key, entry] : current)
+        {
+            if (!isPlain(key))
+                continue;
+
+            std::string line(key.begin(), key.end());
+            snprintf(buf, sizeof(buf), "\t%016llx", (unsigned long long)entry.inputHash);
+            line += '\t' + entry.settings + buf;
+
+            bool bPlain = true;
+            for (const OutputFile& out : entry.outputs)
+            {
+                bPlain = bPlain && isPlain(out.name);
+                snprintf(buf, sizeof(buf), "\t%llx\t%016llx", (unsigned long long)out.size, (unsigned long long)out.hash);
+                line += '\t' + std::string(out.name.begin(), out.name.end()) + buf;
+            }
+
+            if (bPlain)
+                text += line + '\n';
+        }
+
+        // write next to it and swap, so an interrupted run can't leave a half written cache behind
+        std::filesystem::path cachePath = outFolder / FILE_NAME;
+        std::filesystem::path tmpPath = cachePath;
+        tmpPath += ".tmp";
+
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                throw std::runtime_error(strerror(errno));
+
+            file.write(text.data(), text.size());
+            if (!file.good())
+                throw std::runtime_error(strerror(errno));
+        }
+
+        std::filesystem::rename(tmpPath, cachePath);
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+#ifndef FOLDERCACHE_HDR
+#define FOLDERCACHE_HDR
+
+//
+// Incremental rebuild cache for the folder modes.
+// A sidecar file in the output folder remembers, per converted file, a hash of its inputs, the settings it was converted with
+// and the size + hash of every output it wrote. Files whose inputs and outputs still match are skipped on the next run.
+//
+namespace FolderCache
+{
+    //
+    // XXH64 of a memory block
+    //
+    uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+
+    //
+    // Hashes a whole file. Throws if it can't be read.
+    //
+    uint64_t HashFile(const std::filesystem::path& path, uintmax_t& size);
+
+    //
+    // Combined hash of the names, sizes and contents of a conversion's input files. Throws if one can't be read.
+    //
+    uint64_t HashInputs(const std::vector<std::filesystem::path>& inputs);
+
+    struct OutputFile
+    {
+        std::u8string name;         // relative to the output folder
+        uintmax_t size = 0;
+        uint64_t hash = 0;
+    };
+
+    struct Entry
+    {
+        std::string settings;
+        uint64_t inputHash = 0;
+        std::vector<OutputFile> outputs;
+    };
+
+    class Cache
+    {
+    private:
+        std::mutex mtx;
+        std::filesystem::path outFolder;
+        std::unordered_map<std::u8string, Entry> previous;  // loaded from the last run
+        std::unordered_map<std::u8string, Entry> current;   // confirmed in this run, only these get saved
+
+    public:
+        static constexpr const char* FILE_NAME = ".tfstring-cache";
+
+        //
+        // Loads the cache of an output folder. A missing or unreadable cache file just means everything gets converted.
+        //
+        explicit Cache(const std::filesystem::path& outputFolder);
+
+        //
+        // Checks if the conversion stored under key was done with the same settings and inputs, and that its outputs are still intact
+        //
+        bool isUpToDate(const std::u8string& key, const std::string& settings, uint64_t inputHash);
+
+        //
+        // Records a finished conversion, hashing the outputs it wrote (which have to be in the output folder)
+        //
+        void store(const std::u8string& key, const std::string& settings, uint64_t inputHash, const std::vector<std::filesystem::path>& outputs);
+
+        //
+        // Writes the cache file, replacing the old one. Throws on failure.
+        //
+        void save();
+    };
+}
+
+#endif
@@ -0,0 +1,459 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+
+#ifndef TFSTRINGJSON_HDR
+#define TFSTRINGJSON_HDR
+
+//
+// Just enough JSON for job descriptions and reports: a small DOM parser and a string builder.
+// Strings are kept as UTF-8.
+//
+namespace Json
+{
+	class Value
+	{
+	public:
+		enum Type
+		{
+			TYPE_NULL,
+			TYPE_BOOL,
+			TYPE_NUMBER,
+			TYPE_STRING,
+			TYPE_ARRAY,
+			TYPE_OBJECT
+		};
+
+		Type type = TYPE_NULL;
+		bool boolean = false;
+		double number = 0.0;
+		std::string str;
+		std::vector<Value> items;
+		std::vector<std::pair<std::string, Value>> members;
+
+		bool isNull() const { return type == TYPE_NULL; }
+		bool isBool() const { return type == TYPE_BOOL; }
+		bool isNumber() const { return type == TYPE_NUMBER; }
+		bool isString() const { return type == TYPE_STRING; }
+		bool isArray() const { return type == TYPE_ARRAY; }
+		bool isObject() const { return type == TYPE_OBJECT; }
+
+		//
+		// Looks up an object member, nullptr if there's none (or this isn't an object)
+		//
+		const Value* find(std::string_view key) const
+		{
+			for (const auto& member : members)
+			{
+				if (member.first == key)
+					return &member.second;
+			}
+
+			return nullptr;
+		}
+	};
+
+	class Parser
+	{
+	private:
+		const char* p;
+		const char* end;
+		std::string error;
+
+		bool fail(const char* msg)
+		{
+			if (error.empty())
+				error = msg;
+			return false;
+		}
+
+		void skipSpace()
+		{
+			while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')))
+				p++;
+		}
+
+		bool literal(const char* word)
+		{
+			for (; *word; word++, p++)
+			{
+				if ((p >= end) || (*p != *word))
+					return fail("Invalid literal");
+			}
+
+			return true;
+		}
+
+		static void appendUTF8(std::string& out, uint32_t cp)
+		{
+			if (cp < 0x80)
+			{
+				out.push_back((char)cp);
+			}
+			else if (cp < 0x800)
+			{
+				out.push_back((char)(0xC0 | (cp >> 6)));
+				out.push_back((char)(0x80 | (cp & 0x3F)));
+			}
+			else if (cp < 0x10000)
+			{
+				out.push_back((char)(0xE0 | (cp >> 12)));
+				out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+				out.push_back((char)(0x80 | (cp & 0x3F)));
+			}
+			else
+			{
+				out.push_back((char)(0xF0 | (cp >> 18)));
+				out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+				out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+				out.push_back((char)(0x80 | (cp & 0x3F)));
+			}
+		}
+
+		bool hex4(uint32_t& out)
+		{
+			if ((end - p) < 4)
+				return fail("Truncated \\u escape");
+
+			std::from_chars_result res = std::from_chars(p, p + 4, out, 16);
+			if (res.ptr != (p + 4))
+				return fail("Invalid \\u escape");
+
+			p += 4;
+			return true;
+		}
+
+		bool parseString(std::string& out)
+		{
+			// opening quote was checked by the caller
+			p++;
+
+			while (p < end)
+			{
+				char ch = *p++;
+				if (ch == '"')
+					return true;
+
+				if (ch != '\\')
+				{
+					out.push_back(ch);
+					continue;
+				}
+
+				if (p >= end)
+					break;
+
+				char esc = *p++;
+				switch (esc)
+				{
+				case '"': out.push_back('"'); break;
+				case '\\': out.push_back('\\'); break;
+				case '/': out.push_back('/'); break;
+				case 'b': out.push_back('\b'); break;
+				case 'f': out.push_back('\f'); break;
+				case 'n': out.push_back('\n'); break;
+				case 'r': out.push_back('\r'); break;
+				case 't': out.push_back('\t'); break;
+				case 'u':
+				{
+					uint32_t cp;
+					if (!hex4(cp))
+						return false;
+
+					// surrogate pair
+					if ((cp >= 0xD800) && (cp <= 0xDBFF) && ((end - p) >= 6) && (p[0] == '\\') && (p[1] == 'u'))
+					{
+						p += 2;
+						uint32_t lo;
+						if (!hex4(lo))
+							return false;
+						if ((lo >= 0xDC00) && (lo <= 0xDFFF))
+							cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+						else
+							return fail("Invalid surrogate pair");
+					}
+
+					appendUTF8(out, cp);
+					break;
+				}
+				default:
+					return fail("Invalid escape");
+				}
+			}
+
+			return fail("Unterminated string");
+		}
+
+		bool parseValue(Value& out, int depth)
+		{
+			if (depth > 64)
+				return fail("Nested too deeply");
+
+			skipSpace();
+			if (p >= end)
+				return fail("Unexpected end of input");
+
+			switch (*p)
+			{
+			case '{':
+			{
+				out.type = Value::TYPE_OBJECT;
+				p++;
+				skipSpace();
+				if ((p < end) && (*p == '}'))
+				{
+					p++;
+					return true;
+				}
+
+				while (true)
+				{
+					skipSpace();
+					if ((p >= end) || (*p != '"'))
+						return fail("Expected a member name");
+
+					std::pair<std::string, Value> member;
+					if (!parseString(member.first))
+						return false;
+
+					skipSpace();
+					if ((p >= end) || (*p != ':'))
+						return fail("Expected ':'");
+					p++;
+
+					if (!parseValue(member.second, depth + 1))
+						return false;
+					out.members.push_back(std::move(member));
+
+					skipSpace();
+					if ((p < end) && (*p == ','))
+					{
+						p++;
+						continue;
+					}
+					if ((p < end) && (*p == '}'))
+					{
+						p++;
+						return true;
+					}
+
+					return fail("Expected ',' or '}'");
+				}
+			}
+			case '[':
+			{
+				out.type = Value::TYPE_ARRAY;
+				p++;
+				skipSpace();
+				if ((p < end) && (*p == ']'))
+				{
+					p++;
+					return true;
+				}
+
+				while (true)
+				{
+					out.items.emplace_back();
+					if (!parseValue(out.items.back(), depth + 1))
+						return false;
+
+					skipSpace();
+					if ((p < end) && (*p == ','))
+					{
+						p++;
+						continue;
+					}
+					if ((p < end) && (*p == ']'))
+					{
+						p++;
+						return true;
+					}
+
+					return fail("Expected ',' or ']'");
+				}
+			}
+			case '"':
+				out.type = Value::TYPE_STRING;
+				return parseString(out.str);
+			case 't':
+				out.type = Value::TYPE_BOOL;
+				out.boolean = true;
+				return literal("true");
+			case 'f':
+				out.type = Value::TYPE_BOOL;
+				out.boolean = false;
+				return literal("false");
+			case 'n':
+				out.type = Value::TYPE_NULL;
+				return literal("null");
+			default:
+			{
+				// strtod wants a terminated string
+				const char* start = p;
+				while ((p < end) && (((*p >= '0') && (*p <= '9')) || (*p == '-') || (*p == '+') || (*p == '.') || (*p == 'e') || (*p == 'E')))
+					p++;
+
+				std::string numStr(start, p);
+				char* numEnd = nullptr;
+				out.type = Value::TYPE_NUMBER;
+				out.number = strtod(numStr.c_str(), &numEnd);
+				if (numStr.empty() || (numEnd != (numStr.c_str() + numStr.size())))
+					return fail("Invalid value");
+
+				return true;
+			}
+			}
+		}
+
+	public:
+		//
+		// Parses a complete document. Returns false and sets the error message on failure.
+		//
+		bool parse(std::string_view text, Value& out)
+		{
+			p = text.data();
+			end = text.data() + text.size();
+			error.clear();
+			out = Value();
+
+			if (!parseValue(out, 0))
+				return false;
+
+			skipSpace();
+			if (p != end)
+				return fail("Trailing characters after the value");
+
+			return true;
+		}
+
+		const std::string& lastError()
+		{
+			return error;
+		}
+	};
+
+	//
+	// Appends a JSON string literal (with quotes) to out
+	//
+	inline void appendString(std::string& out, std::string_view str)
+	{
+		out.push_back('"');
+		for (unsigned char ch : str)
+		{
+			switch (ch)
+			{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (ch < 0x20)
+				{
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", ch);
+					out += buf;
+				}
+				else
+				{
+					out.push_back((char)ch);
+				}
+				break;
+			}
+		}
+		out.push_back('"');
+	}
+
+	//
+	// Builds a single JSON object member by member, e.g. Object().add("id", 5).add("ok", true).str()
+	//
+	class Object
+	{
+	private:
+		std::string text;
+
+		void key(std::string_view name)
+		{
+			text.push_back(text.empty() ? '{' : ',');
+			appendString(text, name);
+			text.push_back(':');
+		}
+
+	public:
+		Object& add(std::string_view name, std::string_view value)
+		{
+			key(name);
+			appendString(text, value);
+			return *this;
+		}
+
+		Object& add(std::string_view name, const char* value)
+		{
+			return add(name, std::string_view(value));
+		}
+
+		Object& add(std::string_view name, const std::string& value)
+		{
+			return add(name, std::string_view(value));
+		}
+
+		Object& add(std::string_view name, bool value)
+		{
+			key(name);
+			text += value ? "true" : "false";
+			return *this;
+		}
+
+		Object& add(std::string_view name, int64_t value)
+		{
+			key(name);
+			char buf[24];
+			text.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);
+			return *this;
+		}
+
+		Object& add(std::string_view name, int value)
+		{
+			return add(name, (int64_t)value);
+		}
+
+		Object& add(std::string_view name, uint64_t value)
+		{
+			key(name);
+			char buf[24];
+			text.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);
+			return *this;
+		}
+
+		Object& add(std::string_view name, double value)
+		{
+			key(name);
+			char buf[32];
+			snprintf(buf, sizeof(buf), "%.3f", value);
+			text += buf;
+			return *this;
+		}
+
+		//
+		// Adds an already formatted JSON value (object, array, null...)
+		//
+		Object& addRaw(std::string_view name, std::string_view json)
+		{
+			key(name);
+			text += json;
+			return *this;
+		}
+
+		std::string str() const
+		{
+			return text.empty() ? std::string("{}") : (text + '}');
+		}
+	};
+}
+
+#endif
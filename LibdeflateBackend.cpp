@@ -0,0 +1,186 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include "ZlibWrapper.hpp"
+
+// only compiled in with TFSTRING_USE_LIBDEFLATE, the Visual Studio project lists it but builds it empty
+#ifdef TFSTRING_USE_LIBDEFLATE
+#include <memory>
+#include <libdeflate.h>
+#include "FileBuffer.hpp"
+
+namespace ZLibWrapper
+{
+    struct DecompressorDeleter
+    {
+        void operator()(libdeflate_decompressor* d) const
+        {
+            libdeflate_free_decompressor(d);
+        }
+    };
+
+    struct CompressorDeleter
+    {
+        void operator()(libdeflate_compressor* c) const
+        {
+            libdeflate_free_compressor(c);
+        }
+    };
+
+    //
+    // One decompressor per thread, they're reusable but not thread safe
+    //
+    static libdeflate_decompressor* getDecompressor()
+    {
+        thread_local std::unique_ptr<libdeflate_decompressor, DecompressorDeleter> decompressor(libdeflate_alloc_decompressor());
+        if (!decompressor)
+            throw std::bad_alloc();
+
+        return decompressor.get();
+    }
+
+    //
+    // libdeflate backend. It only works on whole buffers, which is all we need since every file fits in memory.
+    //
+    class LibdeflateBackend : public GzBackend
+    {
+    public:
+        const char* name() const override
+        {
+            return "libdeflate";
+        }
+
+        bool extractGzFile(std::filesystem::path gzFilePath, std::vector<uint8_t>& output) override;
+        bool packGzFile(const uint8_t* buffer, uintmax_t size, std::filesystem::path gzFilePath, const GzParams& params) override;
+    };
+
+    //
+    // A file that isn't gzipped at all is passed through as-is, like gzread does
+    //
+    bool LibdeflateBackend::extractGzFile(std::filesystem::path gzFilePath, std::vector<uint8_t>& output)
+    {
+        FileBuffer gzData;
+        try
+        {
+            gzData.openFile(gzFilePath);
+        }
+        catch (const std::exception&)
+        {
+            std::string errmsg = "Can't open the gzip file for reading: " + gzFilePath.string();
+            throw std::runtime_error(errmsg);
+            return false;
+        }
+
+        const uint8_t* in = gzData.data();
+        size_t inLeft = gzData.size();
+
+        auto isGzipMember = [](const uint8_t* p, size_t len)
+        {
+            return (len >= 2) && (p[0] == 0x1F) && (p[1] == 0x8B);
+        };
+
+        if (!isGzipMember(in, inLeft))
+        {
+            output.assign(in, in + inLeft);
+            return true;
+        }
+
+        const size_t minGrowth = 64 * 1024;
+        size_t outSize = 0;
+
+        output.clear();
+        output.resize(getInflatedSizeHint(in, inLeft));
+
+        libdeflate_decompressor* decompressor = getDecompressor();
+        while (isGzipMember(in, inLeft))
+        {
+            size_t inUsed = 0;
+            size_t outUsed = 0;
+            libdeflate_result result = libdeflate_gzip_decompress_ex(decompressor, in, inLeft, output.data() + outSize, output.size() - outSize, &inUsed, &outUsed);
+
+            if (result == LIBDEFLATE_INSUFFICIENT_SPACE)
+            {
+                // the member gets decompressed again from its start
+                output.resize(output.size() + std::max(output.size() / 2, minGrowth));
+                continue;
+            }
+
+            if (result != LIBDEFLATE_SUCCESS)
+            {
+                std::string errmsg = "Can't read gzipped file: " + gzFilePath.string();
+                throw std::runtime_error(errmsg);
+
+                return false;
+            }
+
+            in += inUsed;
+            inLeft -= inUsed;
+            outSize += outUsed;
+        }
+
+        output.resize(outSize);
+
+        return true;
+    }
+
+    //
+    // Compresses a whole buffer into gzip format
+    //
+    static void compressGzBuffer(const uint8_t* buffer, uintmax_t size, const GzParams& params, std::vector<uint8_t>& output)
+    {
+        int level = params.level;
+        if (level < 0)
+            level = 6;
+        else if (level >= 9)
+            level = 12;
+
+        std::unique_ptr<libdeflate_compressor, CompressorDeleter> compressor(libdeflate_alloc_compressor(level));
+        if (!compressor)
+            throw std::bad_alloc();
+
+        output.resize(libdeflate_gzip_compress_bound(compressor.get(), size));
+
+        size_t outSize = libdeflate_gzip_compress(compressor.get(), buffer, size, output.data(), output.size());
+        if (outSize == 0)
+            throw std::runtime_error("Failed to compress data");
+
+        output.resize(outSize);
+    }
+
+    bool LibdeflateBackend::packGzFile(const uint8_t* buffer, uintmax_t size, std::filesystem::path gzFilePath, const GzParams& params)
+    {
+        std::vector<uint8_t> compressed;
+        compressGzBuffer(buffer, size, params, compressed);
+
+        std::ofstream ofile(gzFilePath, std::ios::out | std::ios::binary);
+        if (!ofile.is_open())
+        {
+            std::string errmsg = "Can't open a gzip file for writing: " + gzFilePath.string();
+            throw std::runtime_error(errmsg);
+
+            return false;
+        }
+
+        ofile.write((const char*)compressed.data(), compressed.size());
+        ofile.close();
+        if (ofile.fail())
+        {
+            std::string errmsg = "Failed to write data to: " + gzFilePath.string();
+            throw std::runtime_error(errmsg);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    GzBackend& libdeflateBackend()
+    {
+        static LibdeflateBackend backend;
+        return backend;
+    }
+}
+
+#endif
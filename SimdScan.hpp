@@ -0,0 +1,170 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(TFSTRING_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define SIMDSCAN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifndef SIMDSCAN_HDR
+#define SIMDSCAN_HDR
+
+//
+// Finds the next occurrence of any of a few code units (8 or 16-bit) in a buffer.
+// Uses AVX2 or SSE2 when the CPU has them (picked once at runtime), otherwise a plain loop.
+//
+namespace SimdScan
+{
+	enum Level
+	{
+		LEVEL_SCALAR,
+		LEVEL_SSE2,
+		LEVEL_AVX2
+	};
+
+	inline Level detectLevel()
+	{
+#ifdef SIMDSCAN_X86
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return LEVEL_SSE2;
+
+		// AVX2 needs the OS to save the YMM registers too
+		__cpuid(info, 1);
+		bool bOSXSave = (info[2] & (1 << 27)) != 0;
+		bool bAVX = (info[2] & (1 << 28)) != 0;
+		if (!bOSXSave || !bAVX || ((_xgetbv(0) & 6) != 6))
+			return LEVEL_SSE2;
+
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5))
+			return LEVEL_AVX2;
+
+		return LEVEL_SSE2;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return LEVEL_AVX2;
+
+		return LEVEL_SSE2;
+#endif
+#else
+		return LEVEL_SCALAR;
+#endif
+	}
+
+	inline Level level()
+	{
+		static const Level detected = detectLevel();
+		return detected;
+	}
+
+	template<typename CharT, typename... Needles>
+	const CharT* findAnyScalar(const CharT* p, const CharT* end, Needles... needles)
+	{
+		for (; p < end; p++)
+		{
+			if (((*p == needles) || ...))
+				return p;
+		}
+
+		return end;
+	}
+
+#ifdef SIMDSCAN_X86
+	inline unsigned int lowestBit(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	template<typename CharT, typename... Needles>
+	const CharT* findAnySSE2(const CharT* p, const CharT* end, Needles... needles)
+	{
+		constexpr ptrdiff_t step = 16 / sizeof(CharT);
+
+		while ((end - p) >= step)
+		{
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			__m128i hits = _mm_setzero_si128();
+			if constexpr (sizeof(CharT) == 1)
+				((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(needles))))), ...);
+			else
+				((hits = _mm_or_si128(hits, _mm_cmpeq_epi16(block, _mm_set1_epi16(static_cast<short>(needles))))), ...);
+
+			uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+			if (mask)
+				return p + (lowestBit(mask) / sizeof(CharT));
+
+			p += step;
+		}
+
+		return findAnyScalar(p, end, needles...);
+	}
+
+	template<typename CharT, typename... Needles>
+#ifndef _MSC_VER
+	__attribute__((target("avx2")))
+#endif
+	const CharT* findAnyAVX2(const CharT* p, const CharT* end, Needles... needles)
+	{
+		constexpr ptrdiff_t step = 32 / sizeof(CharT);
+
+		while ((end - p) >= step)
+		{
+			__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			__m256i hits = _mm256_setzero_si256();
+			if constexpr (sizeof(CharT) == 1)
+				((hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(static_cast<char>(needles))))), ...);
+			else
+				((hits = _mm256_or_si256(hits, _mm256_cmpeq_epi16(block, _mm256_set1_epi16(static_cast<short>(needles))))), ...);
+
+			uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+			if (mask)
+				return p + (lowestBit(mask) / sizeof(CharT));
+
+			p += step;
+		}
+
+		// the tail still gets a 16 byte pass
+		return findAnySSE2(p, end, needles...);
+	}
+#endif
+
+	//
+	// Returns a pointer to the first unit in [p, end) that equals one of the needles, or end if there is none.
+	//
+	template<typename CharT, typename... Needles>
+	const CharT* findAny(const CharT* p, const CharT* end, Needles... needles)
+	{
+		static_assert((sizeof(CharT) == 1) || (sizeof(CharT) == 2), "Only 8 and 16-bit code units are supported");
+		static_assert((sizeof...(Needles) >= 1) && (sizeof...(Needles) <= 3), "Between 1 and 3 needles are supported");
+
+#ifdef SIMDSCAN_X86
+		switch (level())
+		{
+		case LEVEL_AVX2:
+			return findAnyAVX2(p, end, static_cast<CharT>(needles)...);
+		case LEVEL_SSE2:
+			return findAnySSE2(p, end, static_cast<CharT>(needles)...);
+		default:
+			break;
+		}
+#endif
+
+		return findAnyScalar(p, end, static_cast<CharT>(needles)...);
+	}
+}
+
+#endif
@@ -0,0 +1,204 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "Stats.hpp"
+
+namespace Stats
+{
+    struct AtomicStage
+    {
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> nanoseconds{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+    };
+
+    static std::atomic<bool> bEnabled{ false };
+    static AtomicStage stageTotals[STAGE_COUNT];
+    static std::atomic<uint64_t> counterTotals[COUNTER_COUNT];
+
+    // innermost running scope of this thread
+    static thread_local Scope* pCurrentScope = nullptr;
+
+    //
+    // Every thread records its trace events into its own buffer, so workers don't wait on each other.
+    // The buffers outlive their threads (pool threads are gone by the time the trace is written).
+    //
+    struct ThreadTrace
+    {
+        uint32_t threadId = 0;
+        std::vector<TraceEvent> events;
+    };
+
+    static std::atomic<bool> bTracing{ false };
+    static std::chrono::steady_clock::time_point traceOrigin;
+    static std::mutex traceMutex;
+    static std::vector<std::unique_ptr<ThreadTrace>> traceThreads;
+    static thread_local ThreadTrace* pThreadTrace = nullptr;
+
+    static ThreadTrace& GetThreadTrace()
+    {
+        if (pThreadTrace == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(traceMutex);
+            traceThreads.push_back(std::make_unique<ThreadTrace>());
+            pThreadTrace = traceThreads.back().get();
+            pThreadTrace->threadId = static_cast<uint32_t>(traceThreads.size() - 1);
+        }
+
+        return *pThreadTrace;
+    }
+
+    static void RecordEvent(std::string name, const char* category, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+        uint64_t bytes, std::string detail)
+    {
+        ThreadTrace& trace = GetThreadTrace();
+
+        TraceEvent event;
+        event.name = std::move(name);
+        event.category = category;
+        event.threadId = trace.threadId;
+        event.startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - traceOrigin).count();
+        event.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        event.bytes = bytes;
+        event.detail = std::move(detail);
+        trace.events.push_back(std::move(event));
+    }
+
+    void Enable(bool bEnable)
+    {
+        bEnabled.store(bEnable, std::memory_order_relaxed);
+    }
+
+    bool IsEnabled()
+    {
+        return bEnabled.load(std::memory_order_relaxed);
+    }
+
+    void Reset()
+    {
+        for (AtomicStage& totals : stageTotals)
+        {
+            totals.calls = 0;
+            totals.nanoseconds = 0;
+            totals.bytes = 0;
+        }
+
+        for (auto& counter : counterTotals)
+            counter = 0;
+    }
+
+    Totals Collect()
+    {
+        Totals totals;
+        for (int i = 0; i < STAGE_COUNT; i++)
+        {
+            totals.stages[i].calls = stageTotals[i].calls.load(std::memory_order_relaxed);
+            totals.stages[i].nanoseconds = stageTotals[i].nanoseconds.load(std::memory_order_relaxed);
+            totals.stages[i].bytes = stageTotals[i].bytes.load(std::memory_order_relaxed);
+        }
+
+        for (int i = 0; i < COUNTER_COUNT; i++)
+            totals.counters[i] = counterTotals[i].load(std::memory_order_relaxed);
+
+        return totals;
+    }
+
+    const char* StageName(Stage stage)
+    {
+        static const char* names[STAGE_COUNT] = { "open", "decompress", "parse", "intern", "build", "escape", "write", "compress" };
+        return ((stage >= 0) && (stage < STAGE_COUNT)) ? names[stage] : "unknown";
+    }
+
+    const char* CounterName(Counter counter)
+    {
+        static const char* names[COUNTER_COUNT] = { "strings_parsed", "strings_exported", "strings_unique", "tail_merge_saved_bytes", "files_skipped" };
+        return ((counter >= 0) && (counter < COUNTER_COUNT)) ? names[counter] : "unknown";
+    }
+
+    void Add(Counter counter, uint64_t value)
+    {
+        if (IsEnabled())
+            counterTotals[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void EnableTrace(bool bEnable)
+    {
+        if (bEnable)
+        {
+            // the first thread to record is thread 0
+            traceOrigin = std::chrono::steady_clock::now();
+            GetThreadTrace();
+        }
+
+        bTracing.store(bEnable, std::memory_order_relaxed);
+    }
+
+    bool IsTracing()
+    {
+        return bTracing.load(std::memory_order_relaxed);
+    }
+
+    std::vector<TraceEvent> CollectTrace()
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+
+        std::vector<TraceEvent> events;
+        for (const auto& trace : traceThreads)
+            events.insert(events.end(), trace->events.begin(), trace->events.end());
+
+        return events;
+    }
+
+    TraceSpan::TraceSpan(std::string_view spanName, std::string_view spanDetail) : bActive(IsTracing())
+    {
+        if (!bActive)
+            return;
+
+        name = spanName;
+        detail = spanDetail;
+        start = std::chrono::steady_clock::now();
+    }
+
+    TraceSpan::~TraceSpan()
+    {
+        if (bActive)
+            RecordEvent(std::move(name), "span", start, std::chrono::steady_clock::now(), 0, std::move(detail));
+    }
+
+    void Scope::begin()
+    {
+        auto now = std::chrono::steady_clock::now();
+
+        // the outer stage doesn't run while this one does
+        pParent = pCurrentScope;
+        if (pParent)
+            pParent->elapsed += now - pParent->start;
+
+        pCurrentScope = this;
+        start = now;
+        opened = now;
+    }
+
+    void Scope::end()
+    {
+        auto now = std::chrono::steady_clock::now();
+        elapsed += now - start;
+
+        AtomicStage& totals = stageTotals[stage];
+        totals.calls.fetch_add(1, std::memory_order_relaxed);
+        totals.nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+        totals.bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+        pCurrentScope = pParent;
+        if (pParent)
+            pParent->start = now;
+
+        if (IsTracing())
+            RecordEvent(StageName(stage), "stage", opened, now, bytes, std::string());
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef STATS_HDR
+#define STATS_HDR
+
+//
+// Per-stage timers and counters of the converters, summed over all threads.
+// The same scopes can also be recorded one by one as a trace (Chrome trace event format).
+// Everything is off until Enable() / EnableTrace() is called, a disabled scope only checks a flag.
+//
+namespace Stats
+{
+    enum Stage
+    {
+        STAGE_OPEN,         // opening / mapping input files
+        STAGE_DECOMPRESS,   // inflating gzipped inputs
+        STAGE_PARSE,        // splitting txt files into strings
+        STAGE_INTERN,       // deduplicating strings into a data block
+        STAGE_BUILD,        // assembling binary resources
+        STAGE_ESCAPE,       // formatting txt output in memory
+        STAGE_WRITE,        // writing output files
+        STAGE_COMPRESS,     // gzipping output files
+        STAGE_COUNT
+    };
+
+    enum Counter
+    {
+        COUNTER_STRINGS_PARSED,
+        COUNTER_STRINGS_EXPORTED,
+        COUNTER_STRINGS_UNIQUE,     // left after deduplication
+        COUNTER_TAIL_MERGE_SAVED,   // bytes
+        COUNTER_FILES_SKIPPED,      // up to date in incremental folder runs
+        COUNTER_COUNT
+    };
+
+    struct StageTotals
+    {
+        uint64_t calls = 0;         // times the stage was entered
+        uint64_t nanoseconds = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Totals
+    {
+        StageTotals stages[STAGE_COUNT];
+        uint64_t counters[COUNTER_COUNT] = {};
+    };
+
+    void Enable(bool bEnable);
+
+    bool IsEnabled();
+
+    //
+    // Clears all totals
+    //
+    void Reset();
+
+    //
+    // Current totals of all threads
+    //
+    Totals Collect();
+
+    const char* StageName(Stage stage);
+
+    const char* CounterName(Counter counter);
+
+    void Add(Counter counter, uint64_t value);
+
+    struct TraceEvent
+    {
+        std::string name;
+        const char* category = "";
+        uint32_t threadId = 0;      // 0 is the thread that enabled tracing, the others are numbered as they show up
+        uint64_t startNs = 0;       // since tracing was enabled
+        uint64_t durationNs = 0;
+        uint64_t bytes = 0;
+        std::string detail;
+    };
+
+    //
+    // Starts (or stops) recording every scope and span as a trace event. The calling thread becomes thread 0.
+    //
+    void EnableTrace(bool bEnable);
+
+    bool IsTracing();
+
+    //
+    // All events recorded so far, per thread in the order they ended. Only call this while no conversion is running.
+    //
+    std::vector<TraceEvent> CollectTrace();
+
+    //
+    // A named span in the trace (e.g. one file pair of a folder conversion). Doesn't count towards any stage.
+    //
+    class TraceSpan
+    {
+    private:
+        bool bActive;
+        std::string name;
+        std::string detail;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit TraceSpan(std::string_view spanName, std::string_view spanDetail = std::string_view());
+        ~TraceSpan();
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+    };
+
+    //
+    // Times a stage for as long as it's alive.
+    // Scopes nest per thread: while an inner scope runs the outer one is paused, so every stage only gets its own time.
+    //
+    class Scope
+    {
+    private:
+        Stage stage;
+        bool bActive;
+        uint64_t bytes;
+        std::chrono::steady_clock::duration elapsed;   // up to the last pause
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point opened;   // for the trace, pauses don't matter there
+        Scope* pParent;
+
+        void begin();
+        void end();
+
+    public:
+        explicit Scope(Stage scopeStage) : stage(scopeStage), bActive(IsEnabled() || IsTracing()), bytes(0), elapsed(0), pParent(nullptr)
+        {
+            if (bActive)
+                begin();
+        }
+
+        ~Scope()
+        {
+            if (bActive)
+                end();
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        //
+        // Amount of data the stage went through (input size for reading stages, output size for writing ones)
+        //
+        void addBytes(uint64_t count)
+        {
+            bytes += count;
+        }
+    };
+}
+
+#endif
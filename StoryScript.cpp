@@ -0,0 +1,326 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include "StoryScript.hpp"
+#include "TxtWriter.hpp"
+#include "Stats.hpp"
+
+namespace StoryScript
+{
+    int ExportU16(TFStoryScript& tfs, std::filesystem::path txtFilename, bool bWriteBOM, bool bAliases)
+    {
+        TxtWriter<char16_t> txtfile;
+        try
+        {
+            txtfile.open(txtFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        Stats::Scope scope(Stats::STAGE_ESCAPE);
+        scope.addBytes(tfs.datasize());
+        Stats::Add(Stats::COUNTER_STRINGS_EXPORTED, tfs.count());
+
+        // strings plus roughly 8 units of section header per entry
+        txtfile.reserve(tfs.datasize() / sizeof(char16_t) + tfs.count() * 8);
+
+        if (bWriteBOM)
+        {
+            // write BOM
+            txtfile.putBOM();
+        }
+
+        // strings shared by several entries are only escaped once
+        const std::vector<StringEntry>& index = tfs.stringIndex16();
+        txtfile.reserveEntries(index.size());
+
+        for (int i = 0; i < tfs.count(); i++)
+        {
+            // an entry sharing an earlier entry's string only points at it
+            if (bAliases && (index[i].first != static_cast<uint32_t>(i)))
+            {
+                txtfile.aliasSection(i, index[i].first);
+                continue;
+            }
+
+            // write section
+            txtfile.section(i);
+
+            // write data
+            std::u16string_view u16data = tfs.view16(i);
+            txtfile.appendEscapedEntry(i, index[i].first, u16data.data(), u16data.size());
+
+            // newline for next section
+            txtfile.put(u'\n');
+        }
+
+        if (!txtfile.close())
+        {
+            TagForceString::ConErr() << "ERROR: Failed to write file: " << txtFilename.string() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ExportU16(std::filesystem::path idxFilename, std::filesystem::path langFilename, std::filesystem::path txtFilename, bool bWriteBOM, bool bAliases)
+    {
+        TFStoryScript tfs;
+        try
+        {
+            tfs.openFile(idxFilename, langFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open files: " << idxFilename.string() << " and " << langFilename.string() << " for reading.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -1;
+        }
+
+        return ExportU16(tfs, txtFilename, bWriteBOM, bAliases);
+    }
+
+    int ExportU8(TFStoryScript& tfs, std::filesystem::path txtFilename, bool bWriteBOM, bool bAliases)
+    {
+        TxtWriter<char8_t> txtfile;
+        try
+        {
+            txtfile.open(txtFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        Stats::Scope scope(Stats::STAGE_ESCAPE);
+        scope.addBytes(tfs.datasize());
+        Stats::Add(Stats::COUNTER_STRINGS_EXPORTED, tfs.count());
+
+        // strings plus roughly 8 units of section header per entry
+        txtfile.reserve(tfs.datasize() / sizeof(char8_t) + tfs.count() * 8);
+
+        if (bWriteBOM)
+        {
+            // write BOM
+            txtfile.putBOM();
+        }
+
+        // strings shared by several entries are only escaped once
+        const std::vector<StringEntry>& index = tfs.stringIndex8();
+        txtfile.reserveEntries(index.size());
+
+        for (int i = 0; i < tfs.count(); i++)
+        {
+            // an entry sharing an earlier entry's string only points at it
+            if (bAliases && (index[i].first != static_cast<uint32_t>(i)))
+            {
+                txtfile.aliasSection(i, index[i].first);
+                continue;
+            }
+
+            // write section
+            txtfile.section(i);
+
+            // write data
+            std::u8string_view u8data = tfs.view8(i);
+            txtfile.appendEscapedEntry(i, index[i].first, u8data.data(), u8data.size());
+
+            // newline for next section
+            txtfile.put(u8'\n');
+        }
+
+        if (!txtfile.close())
+        {
+            TagForceString::ConErr() << "ERROR: Failed to write file: " << txtFilename.string() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ExportU8(std::filesystem::path idxFilename, std::filesystem::path langFilename, std::filesystem::path txtFilename, bool bWriteBOM, bool bAliases)
+    {
+        TFStoryScript tfs;
+        try
+        {
+            tfs.openFile(idxFilename, langFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open files: " << idxFilename.string() << " and " << langFilename.string() << " for reading.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -1;
+        }
+
+        return ExportU8(tfs, txtFilename, bWriteBOM, bAliases);
+    }
+
+    int ExportRaw(TFStoryScript& tfs, std::filesystem::path txtFilename, bool bAliases)
+    {
+        TxtWriter<char> txtfile;
+        try
+        {
+            txtfile.open(txtFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        Stats::Scope scope(Stats::STAGE_ESCAPE);
+        scope.addBytes(tfs.datasize());
+        Stats::Add(Stats::COUNTER_STRINGS_EXPORTED, tfs.count());
+
+        // strings plus roughly 8 units of section header per entry
+        txtfile.reserve(tfs.datasize() + tfs.count() * 8);
+
+        // only needed to find shared strings
+        const std::vector<StringEntry>* pIndex = bAliases ? &tfs.stringIndex8() : nullptr;
+
+        for (int i = 0; i < tfs.count(); i++)
+        {
+            // an entry sharing an earlier entry's string only points at it
+            if (pIndex && ((*pIndex)[i].first != static_cast<uint32_t>(i)))
+            {
+                txtfile.aliasSection(i, (*pIndex)[i].first);
+                continue;
+            }
+
+            // write section
+            txtfile.section(i);
+
+            // write data, raw txt keeps the terminator of every string
+            std::string_view rawdata = tfs.viewRaw(i);
+            txtfile.append(rawdata.data(), rawdata.size());
+            txtfile.put('\0');
+
+            // newline for next section
+            txtfile.put('\n');
+        }
+
+        if (!txtfile.close())
+        {
+            TagForceString::ConErr() << "ERROR: Failed to write file: " << txtFilename.string() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ExportRaw(std::filesystem::path idxFilename, std::filesystem::path langFilename, std::filesystem::path txtFilename, bool bAliases)
+    {
+        TFStoryScript tfs;
+        try
+        {
+            tfs.openFile(idxFilename, langFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open files: " << idxFilename.string() << " and " << langFilename.string() << " for reading.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -1;
+        }
+
+        return ExportRaw(tfs, txtFilename, bAliases);
+    }
+
+    int ImportU16(std::filesystem::path txtFilename, std::filesystem::path idxFilename, std::filesystem::path langFilename, bool bTailMerge)
+    {
+        std::vector<std::u16string> strings;
+        std::vector<uint32_t> aliases;
+        int errcode = TagForceString::ParseTxtU16(txtFilename, &strings, &aliases);
+        if (errcode < 0)
+        {
+            TagForceString::ConErr() << "ERROR: Text parser failed with code " << errcode << '\n';
+            return errcode;
+        }
+
+        TFStoryScript tfs;
+        tfs.build(&strings, bTailMerge, &aliases);
+        if (bTailMerge)
+            TagForceString::ConOut() << "Tail merging saved " << tfs.tailMergeSavings() << " bytes\n";
+
+        try
+        {
+            tfs.exportFile(idxFilename, langFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open files: " << idxFilename.string() << " and " << langFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ImportU8(std::filesystem::path txtFilename, std::filesystem::path idxFilename, std::filesystem::path langFilename, bool bTailMerge)
+    {
+        std::vector<std::u8string> strings;
+        std::vector<uint32_t> aliases;
+        int errcode = TagForceString::ParseTxtU8(txtFilename, &strings, &aliases);
+        if (errcode < 0)
+        {
+            TagForceString::ConErr() << "ERROR: Text parser failed with code " << errcode << '\n';
+            return errcode;
+        }
+
+        TFStoryScript tfs;
+        tfs.build(&strings, bTailMerge, &aliases);
+        if (bTailMerge)
+            TagForceString::ConOut() << "Tail merging saved " << tfs.tailMergeSavings() << " bytes\n";
+
+        try
+        {
+            tfs.exportFile(idxFilename, langFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open files: " << idxFilename.string() << " and " << langFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ImportRaw(std::filesystem::path txtFilename, std::filesystem::path idxFilename, std::filesystem::path langFilename, bool bTailMerge)
+    {
+        std::vector<std::string> strings;
+        std::vector<uint32_t> aliases;
+        int errcode = TagForceString::ParseTxtRaw(txtFilename, &strings, &aliases);
+        if (errcode < 0)
+        {
+            TagForceString::ConErr() << "ERROR: Text parser failed with code " << errcode << '\n';
+            return errcode;
+        }
+
+        TFStoryScript tfs;
+        tfs.build(&strings, bTailMerge, &aliases);
+        if (bTailMerge)
+            TagForceString::ConOut() << "Tail merging saved " << tfs.tailMergeSavings() << " bytes\n";
+
+        try
+        {
+            tfs.exportFile(idxFilename, langFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open files: " << idxFilename.string() << " and " << langFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,311 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include "StrResource.hpp"
+#include "TxtWriter.hpp"
+#include "Stats.hpp"
+
+namespace StrResource
+{
+    int ExportU16(std::filesystem::path binFilename, std::filesystem::path txtFilename, bool bWriteBOM, bool bAliases)
+    {
+        YgStringResource ysr;
+        try
+        {
+            ysr.openFile(binFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << binFilename.string() << " for reading.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -1;
+        }
+
+        TxtWriter<char16_t> txtfile;
+        try
+        {
+            txtfile.open(txtFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        Stats::Scope scope(Stats::STAGE_ESCAPE);
+        scope.addBytes(ysr.datasize());
+        Stats::Add(Stats::COUNTER_STRINGS_EXPORTED, ysr.count());
+
+        // strings plus roughly 8 units of section header per entry
+        txtfile.reserve(ysr.datasize() / sizeof(char16_t) + ysr.count() * 8);
+
+        if (bWriteBOM)
+        {
+            // write BOM
+            txtfile.putBOM();
+        }
+
+        // strings shared by several entries are only escaped once
+        const std::vector<StringEntry>& index = ysr.stringIndex16();
+        txtfile.reserveEntries(index.size());
+
+        for (int i = 0; i < ysr.count(); i++)
+        {
+            // an entry sharing an earlier entry's string only points at it
+            if (bAliases && (index[i].first != static_cast<uint32_t>(i)))
+            {
+                txtfile.aliasSection(i, index[i].first);
+                continue;
+            }
+
+            // write section
+            txtfile.section(i);
+
+            // write data
+            std::u16string_view u16data = ysr.view16(i);
+            txtfile.appendEscapedEntry(i, index[i].first, u16data.data(), u16data.size());
+
+            // newline for next section
+            txtfile.put(u'\n');
+        }
+
+        if (!txtfile.close())
+        {
+            TagForceString::ConErr() << "ERROR: Failed to write file: " << txtFilename.string() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ExportU8(std::filesystem::path binFilename, std::filesystem::path txtFilename, bool bWriteBOM, bool bAliases)
+    {
+        YgStringResource ysr;
+        try
+        {
+            ysr.openFile(binFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << binFilename.string() << " for reading.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -1;
+        }
+
+        TxtWriter<char8_t> txtfile;
+        try
+        {
+            txtfile.open(txtFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        Stats::Scope scope(Stats::STAGE_ESCAPE);
+        scope.addBytes(ysr.datasize());
+        Stats::Add(Stats::COUNTER_STRINGS_EXPORTED, ysr.count());
+
+        // strings plus roughly 8 units of section header per entry
+        txtfile.reserve(ysr.datasize() / sizeof(char8_t) + ysr.count() * 8);
+
+        if (bWriteBOM)
+        {
+            // write BOM
+            txtfile.putBOM();
+        }
+
+        // strings shared by several entries are only escaped once
+        const std::vector<StringEntry>& index = ysr.stringIndex8();
+        txtfile.reserveEntries(index.size());
+
+        for (int i = 0; i < ysr.count(); i++)
+        {
+            // an entry sharing an earlier entry's string only points at it
+            if (bAliases && (index[i].first != static_cast<uint32_t>(i)))
+            {
+                txtfile.aliasSection(i, index[i].first);
+                continue;
+            }
+
+            // write section
+            txtfile.section(i);
+
+            // write data
+            std::u8string_view u8data = ysr.view8(i);
+            txtfile.appendEscapedEntry(i, index[i].first, u8data.data(), u8data.size());
+
+            // newline for next section
+            txtfile.put(u8'\n');
+        }
+
+        if (!txtfile.close())
+        {
+            TagForceString::ConErr() << "ERROR: Failed to write file: " << txtFilename.string() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ExportRaw(std::filesystem::path binFilename, std::filesystem::path txtFilename, bool bAliases)
+    {
+        YgStringResource ysr;
+        try
+        {
+            ysr.openFile(binFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << binFilename.string() << " for reading.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -1;
+        }
+
+        TxtWriter<char> txtfile;
+        try
+        {
+            txtfile.open(txtFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        Stats::Scope scope(Stats::STAGE_ESCAPE);
+        scope.addBytes(ysr.datasize());
+        Stats::Add(Stats::COUNTER_STRINGS_EXPORTED, ysr.count());
+
+        // strings plus roughly 8 units of section header per entry
+        txtfile.reserve(ysr.datasize() + ysr.count() * 8);
+
+        // only needed to find shared strings
+        const std::vector<StringEntry>* pIndex = bAliases ? &ysr.stringIndex8() : nullptr;
+
+        for (int i = 0; i < ysr.count(); i++)
+        {
+            // an entry sharing an earlier entry's string only points at it
+            if (pIndex && ((*pIndex)[i].first != static_cast<uint32_t>(i)))
+            {
+                txtfile.aliasSection(i, (*pIndex)[i].first);
+                continue;
+            }
+
+            // write section
+            txtfile.section(i);
+
+            // write data, raw txt keeps the terminator of every string
+            std::string_view rawdata = ysr.viewRaw(i);
+            txtfile.append(rawdata.data(), rawdata.size());
+            txtfile.put('\0');
+
+            // newline for next section
+            txtfile.put('\n');
+        }
+
+        if (!txtfile.close())
+        {
+            TagForceString::ConErr() << "ERROR: Failed to write file: " << txtFilename.string() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ImportU16(std::filesystem::path txtFilename, std::filesystem::path binFilename, bool bTailMerge)
+    {
+        std::vector<std::u16string> strings;
+        std::vector<uint32_t> aliases;
+        int errcode = TagForceString::ParseTxtU16(txtFilename, &strings, &aliases);
+        if (errcode < 0)
+        {
+            TagForceString::ConErr() << "ERROR: Text parser failed with code " << errcode << '\n';
+            return errcode;
+        }
+
+        YgStringResource ysr;
+        ysr.build(&strings, bTailMerge, &aliases);
+        if (bTailMerge)
+            TagForceString::ConOut() << "Tail merging saved " << ysr.tailMergeSavings() << " bytes\n";
+
+        try
+        {
+            ysr.exportFile(binFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << binFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ImportU8(std::filesystem::path txtFilename, std::filesystem::path binFilename, bool bTailMerge)
+    {
+        std::vector<std::u8string> strings;
+        std::vector<uint32_t> aliases;
+        int errcode = TagForceString::ParseTxtU8(txtFilename, &strings, &aliases);
+        if (errcode < 0)
+        {
+            TagForceString::ConErr() << "ERROR: Text parser failed with code " << errcode << '\n';
+            return errcode;
+        }
+
+        YgStringResource ysr;
+        ysr.build(&strings, bTailMerge, &aliases);
+        if (bTailMerge)
+            TagForceString::ConOut() << "Tail merging saved " << ysr.tailMergeSavings() << " bytes\n";
+
+        try
+        {
+            ysr.exportFile(binFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << binFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+
+    int ImportRaw(std::filesystem::path txtFilename, std::filesystem::path binFilename, bool bTailMerge)
+    {
+        std::vector<std::string> strings;
+        std::vector<uint32_t> aliases;
+        int errcode = TagForceString::ParseTxtRaw(txtFilename, &strings, &aliases);
+        if (errcode < 0)
+        {
+            TagForceString::ConErr() << "ERROR: Text parser failed with code " << errcode << '\n';
+            return errcode;
+        }
+
+        YgStringResource ysr;
+        ysr.build(&strings, bTailMerge, &aliases);
+        if (bTailMerge)
+            TagForceString::ConOut() << "Tail merging saved " << ysr.tailMergeSavings() << " bytes\n";
+
+        try
+        {
+            ysr.exportFile(binFilename);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open file: " << binFilename.string() << " for writing.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -2;
+        }
+
+        return 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,622 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include <unordered_map>
+#include "TF1Folder.hpp"
+#include "ThreadPool.hpp"
+#include "FolderCache.hpp"
+#include "Stats.hpp"
+
+namespace TF1Folder
+{
+    size_t RunJobs(size_t jobCount, unsigned int nJobs, std::function<int(size_t)> job)
+    {
+        TagForceString::OrderedReporter reporter(jobCount);
+        std::atomic<size_t> failCount = 0;
+
+        WorkStealingPool pool(WorkStealingPool::resolveThreadCount(nJobs));
+        for (size_t i = 0; i < jobCount; i++)
+        {
+            pool.submit([&reporter, &failCount, &job, i]
+            {
+                TagForceString::BufferedConsole console;
+
+                // a throw must not leave the worker thread, and the ordered log still needs this job's output
+                try
+                {
+                    if (job(i) < 0)
+                        failCount++;
+                }
+                catch (const std::exception& e)
+                {
+                    TagForceString::ConErr() << "ERROR: " << e.what() << '\n';
+                    failCount++;
+                }
+
+                reporter.report(i, console.takeOut(), console.takeErr());
+            });
+        }
+        pool.wait();
+
+        return failCount;
+    }
+
+    //
+    // Runs one conversion of a folder mode through the cache (if there is one):
+    // it's skipped when its inputs, settings and outputs didn't change since the last run, and recorded when it succeeds.
+    //
+    static int RunCached(FolderCache::Cache* pCache, const std::u8string& name, const std::string& settings, const std::vector<std::filesystem::path>& inputs,
+        const std::vector<std::filesystem::path>& outputs, std::atomic<size_t>& upToDateCount, const std::function<int()>& convert)
+    {
+        Stats::TraceSpan span((const char*)name.c_str(), inputs.front().string());
+        if (pCache == nullptr)
+            return convert();
+
+        std::u8string key = outputs.front().filename().u8string();
+        uint64_t inputHash = 0;
+        bool bUpToDate = false;
+        try
+        {
+            Stats::TraceSpan cacheSpan("cache check");
+            inputHash = FolderCache::HashInputs(inputs);
+            bUpToDate = pCache->isUpToDate(key, settings, inputHash);
+        }
+        catch (const std::exception&)
+        {
+            // the conversion reports what's wrong with the inputs
+            return convert();
+        }
+
+        if (bUpToDate)
+        {
+            TagForceString::ConOut() << "Processing: " << (char*)name.c_str() << '\n';
+            for (const auto& path : inputs)
+                TagForceString::ConOut() << " <- " << path.string() << '\n';
+            TagForceString::ConOut() << "Up to date, skipped.\n";
+
+            upToDateCount++;
+            Stats::Add(Stats::COUNTER_FILES_SKIPPED, 1);
+            return 0;
+        }
+
+        int result = convert();
+        if (result >= 0)
+            pCache->store(key, settings, inputHash, outputs);
+
+        return result;
+    }
+
+    static void SaveCache(FolderCache::Cache* pCache, size_t upToDateCount, size_t totalCount)
+    {
+        if (pCache == nullptr)
+            return;
+
+        TagForceString::ConOut() << upToDateCount << " of " << totalCount << " files were up to date\n";
+
+        try
+        {
+            pCache->save();
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "WARNING: Can't write the cache file to the output folder, the next run will convert everything again.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+        }
+    }
+
+    //
+    // Everything found in a folder for one <name> + <lang>, filled in a single pass over the folder
+    //
+    struct PairSlot
+    {
+        std::u8string name;
+        std::u8string lang;
+        std::filesystem::path files[2][2];  // [0 = I, 1 = L][plain, compressed]
+        std::filesystem::path firstPath;    // the first half the scan came across, it decides the output name
+        bool bFirstIsIdx = false;
+        bool bFirstCompressed = false;
+    };
+
+    std::vector<LangPair> FindLangPairs(std::filesystem::path inFolder, std::filesystem::path outFolder)
+    {
+        std::vector<LangPair> pairs;
+        std::vector<PairSlot> slots;
+        std::unordered_map<std::u8string, size_t> slotIndex;
+
+        //
+        // expected filenames are in format:
+        // <name><type><lang>.bin
+        // <name><type><lang>.bin.gz
+        //
+        // <name> - arbitrary length
+        // <type> - 1 char - can either be I or L
+        // <lang> - 1 char - first letter of a western language in English, can be: j, e, g, f, i or s (Japanese, English, German, French, Italian or Spanish)
+        //
+
+        for (const auto& entry : std::filesystem::directory_iterator(inFolder))
+        {
+            if ((entry.path().extension() != ".bin") && (entry.path().extension() != ".gz"))
+            {
+                // std::cout << "Skipping file: " << entry.path() << '\n';
+                continue;
+            }
+
+            bool bCompressed = false;
+            size_t posType = 6;
+            if ((entry.path().extension() == ".gz"))
+            {
+                bCompressed = true;
+                posType += 3;
+            }
+
+            std::u8string strEntry = entry.path().filename().u8string();
+            char8_t chType = (strEntry.size() >= posType) ? strEntry[strEntry.size() - posType] : u8'\0';
+
+            if ((chType != u8'L') && (chType != u8'I'))
+            {
+                TagForceString::ConErr() << "ERROR: File " << entry.path() << " does not follow the correct filename format!\n";
+                TagForceString::ConErr() << "Reason: Missing type character ('I' or 'L') in filename!\n";
+
+                continue;
+            }
+
+            std::u8string strName = strEntry.substr(0, strEntry.size() - posType);
+            std::u8string strLang = strEntry.substr(strEntry.size() - posType + 1, 1);
+
+            // '/' can't be part of a file name, so it keeps name + lang combinations apart
+            auto [it, bNew] = slotIndex.try_emplace(strName + u8'/' + strLang, slots.size());
+            if (bNew)
+            {
+                PairSlot& slot = slots.emplace_back();
+                slot.name = strName;
+                slot.lang = strLang;
+                slot.firstPath = entry.path();
+                slot.bFirstIsIdx = (chType == u8'I');
+                slot.bFirstCompressed = bCompressed;
+            }
+
+            slots[it->second].files[(chType == u8'I') ? 0 : 1][bCompressed ? 1 : 0] = entry.path();
+        }
+
+        for (const PairSlot& slot : slots)
+        {
+            // the other half preferably has the same compression as the first one
+            const auto& others = slot.files[slot.bFirstIsIdx ? 1 : 0];
+            bool bOtherCompressed = slot.bFirstCompressed;
+            if (others[bOtherCompressed ? 1 : 0].empty())
+                bOtherCompressed = !bOtherCompressed;
+
+            const std::filesystem::path& otherEntry = others[bOtherCompressed ? 1 : 0];
+            if (otherEntry.empty())
+            {
+                std::u8string strOtherName = slot.name + (slot.bFirstIsIdx ? u8'L' : u8'I') + slot.lang + (slot.bFirstCompressed ? u8".bin" : u8".bin.gz");
+                TagForceString::ConOut() << "Processing: " << (char*)slot.name.c_str() << '\n'
+                    << " <- " << slot.firstPath.string() << '\n';
+                TagForceString::ConErr() << "ERROR: Can't find " << (slot.firstPath.parent_path() / strOtherName).string() << " !\n";
+                continue;
+            }
+
+            std::u8string outName = slot.name + u8'_' + slot.lang;
+            if (slot.bFirstCompressed)
+                outName += u8".gz";
+            outName += u8".txt";
+
+            LangPair pair;
+            pair.name = slot.name;
+            pair.firstPath = slot.firstPath;
+            pair.secondPath = otherEntry;
+            pair.outPath = outFolder / outName;
+
+            if (slot.bFirstIsIdx)
+            {
+                pair.idxPath = slot.firstPath;
+                pair.langPath = otherEntry;
+                pair.bIdxCompressed = slot.bFirstCompressed;
+                pair.bLangCompressed = bOtherCompressed;
+            }
+            else
+            {
+                pair.idxPath = otherEntry;
+                pair.langPath = slot.firstPath;
+                pair.bIdxCompressed = bOtherCompressed;
+                pair.bLangCompressed = slot.bFirstCompressed;
+            }
+
+            pairs.push_back(pair);
+        }
+
+        // directory order is up to the filesystem, keep the job order stable
+        std::sort(pairs.begin(), pairs.end(), [](const LangPair& a, const LangPair& b) { return a.outPath < b.outPath; });
+
+        return pairs;
+    }
+
+    std::span<uint8_t> LoadPairFile(std::filesystem::path path, bool bCompressed, std::vector<uint8_t>& inflated, FileBuffer& mapped)
+    {
+        if (bCompressed)
+        {
+            Stats::Scope scope(Stats::STAGE_DECOMPRESS);
+            ZLibWrapper::extractGzFile(path, inflated);
+            scope.addBytes(inflated.size());
+            return std::span<uint8_t>(inflated.data(), inflated.size());
+        }
+
+        Stats::Scope scope(Stats::STAGE_OPEN);
+        mapped.openFile(path);
+        scope.addBytes(mapped.size());
+        return std::span<uint8_t>(mapped.data(), mapped.size());
+    }
+
+    int ExportPair(const LangPair& pair, TagForceString::TextEncoding encoding, bool bAliases)
+    {
+        TagForceString::ConOut() << "Processing: " << (char*)pair.name.c_str() << '\n'
+            << " <- " << pair.firstPath.string() << '\n'
+            << " <- " << pair.secondPath.string() << '\n'
+            << " -> " << pair.outPath.string() << '\n';
+
+        std::vector<uint8_t> idxInflated;
+        std::vector<uint8_t> langInflated;
+        FileBuffer idxMapped;
+        FileBuffer langMapped;
+        TFStoryScript tfs;
+
+        try
+        {
+            std::span<uint8_t> idxSpan = LoadPairFile(pair.idxPath, pair.bIdxCompressed, idxInflated, idxMapped);
+            std::span<uint8_t> langSpan = LoadPairFile(pair.langPath, pair.bLangCompressed, langInflated, langMapped);
+            tfs.openMemory(idxSpan, langSpan);
+        }
+        catch (const std::exception& e)
+        {
+            TagForceString::ConErr() << "ERROR: Failed to open files: " << pair.idxPath.string() << " and " << pair.langPath.string() << " for reading.\n";
+            TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+            return -1;
+        }
+
+        switch (encoding)
+        {
+            case TagForceString::ENC_RAW:
+                return StoryScript::ExportRaw(tfs, pair.outPath, bAliases);
+            case TagForceString::ENC_UTF8:
+                return StoryScript::ExportU8(tfs, pair.outPath, true, bAliases);
+            default:
+                return StoryScript::ExportU16(tfs, pair.outPath, true, bAliases);
+        }
+    }
+
+    int ExportFolder(std::filesystem::path inFolder, std::filesystem::path outFolder, TagForceString::TextEncoding encoding, unsigned int nJobs, bool bIncremental, bool bAliases)
+    {
+        if (!std::filesystem::exists(inFolder))
+        {
+            TagForceString::ConErr() << "ERROR: Folder " << inFolder.string() << " does not exist!\n";
+            return -1;
+        }
+
+        if (!std::filesystem::exists(outFolder))
+        {
+            try
+            {
+                std::filesystem::create_directory(outFolder);
+            }
+            catch (const std::exception& e)
+            {
+                TagForceString::ConErr() << "ERROR: Folder " << outFolder.string() << " could not be created!\n";
+                TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+                return -2;
+            }
+        }
+
+        Stats::TraceSpan span("fold2txt", inFolder.string());
+        std::vector<LangPair> pairs = FindLangPairs(inFolder, outFolder);
+
+        std::unique_ptr<FolderCache::Cache> pCache;
+        if (bIncremental)
+            pCache = std::make_unique<FolderCache::Cache>(outFolder);
+        std::string settings = "fold2txt enc=" + std::to_string((int)encoding);
+        if (bAliases)
+            settings += " aliases=1";
+        std::atomic<size_t> upToDateCount = 0;
+
+        size_t failCount = RunJobs(pairs.size(), nJobs, [&](size_t i)
+        {
+            const LangPair& pair = pairs[i];
+            return RunCached(pCache.get(), pair.name, settings, { pair.idxPath, pair.langPath }, { pair.outPath }, upToDateCount, [&]
+            {
+                return ExportPair(pair, encoding, bAliases);
+            });
+        });
+
+        SaveCache(pCache.get(), upToDateCount, pairs.size());
+
+        if (failCount)
+        {
+            TagForceString::ConErr() << "WARNING: " << failCount << " of " << pairs.size() << " pairs failed to convert!\n";
+            return -3;
+        }
+
+        return 0;
+    }
+
+    int ExportFolderU16(std::filesystem::path inFolder, std::filesystem::path outFolder, unsigned int nJobs, bool bIncremental, bool bAliases)
+    {
+        return ExportFolder(inFolder, outFolder, TagForceString::ENC_UTF16, nJobs, bIncremental, bAliases);
+    }
+
+    int ExportFolderU8(std::filesystem::path inFolder, std::filesystem::path outFolder, unsigned int nJobs, bool bIncremental, bool bAliases)
+    {
+        return ExportFolder(inFolder, outFolder, TagForceString::ENC_UTF8, nJobs, bIncremental, bAliases);
+    }
+
+    int ExportFolderRaw(std::filesystem::path inFolder, std::filesystem::path outFolder, unsigned int nJobs, bool bIncremental, bool bAliases)
+    {
+        return ExportFolder(inFolder, outFolder, TagForceString::ENC_RAW, nJobs, bIncremental, bAliases);
+    }
+
+    std::vector<TxtEntry> FindTxtFiles(std::filesystem::path inFolder)
+    {
+        std::vector<TxtEntry> entries;
+
+        //
+        // expected filenames are in format:
+        // <name>_<lang>.txt
+        // <name>_<lang>.gz.txt
+        //
+        // <name> - arbitrary length
+        // <lang> - 1 char - first letter of a western language in English, can be: j, e, g, f, i or s (Japanese, English, German, French, Italian or Spanish)
+        //
+
+        for (const auto& entry : std::filesystem::directory_iterator(inFolder))
+        {
+            if (entry.path().extension() != ".txt")
+            {
+                // std::cout << "Skipping file: " << entry.path() << '\n';
+                continue;
+            }
+
+            bool bCompressed = false;
+            size_t posType = 6;
+            std::u8string strEntry = entry.path().filename().u8string();
+            if (strEntry.find(u8".gz") != strEntry.npos)
+            {
+                bCompressed = true;
+                posType += 3;
+            }
+
+            if (strEntry.size() < posType)
+            {
+                TagForceString::ConErr() << "ERROR: File " << entry.path() << " does not follow the correct filename format!\n";
+                TagForceString::ConErr() << "Reason: Filename is too short!\n";
+
+                continue;
+            }
+
+            std::u8string strName = strEntry.substr(0, strEntry.size() - posType);
+            std::u8string strTail = strEntry.substr(strEntry.size() - posType);
+            std::u8string strUnderline = strTail.substr(0, 1);
+            std::u8string strLang = strTail.substr(1, 1);
+
+            if (strUnderline != u8"_")
+            {
+                TagForceString::ConOut() << "Processing: " << (char*)strName.c_str() << '\n'
+                    << " <- " << entry.path().string() << '\n';
+                TagForceString::ConErr() << "ERROR: File " << entry.path() << " does not follow the correct filename format!\n";
+                TagForceString::ConErr() << "Reason: Missing underline character in filename!\n";
+
+                continue;
+            }
+
+            TxtEntry txt;
+            txt.name = strName;
+            txt.lang = strLang;
+            txt.txtPath = entry.path();
+            txt.bCompressed = bCompressed;
+            entries.push_back(txt);
+        }
+
+        // directory order is up to the filesystem, keep the job order stable
+        std::sort(entries.begin(), entries.end(), [](const TxtEntry& a, const TxtEntry& b) { return a.txtPath < b.txtPath; });
+
+        return entries;
+    }
+
+    int ParseAndBuild(std::filesystem::path txtPath, TagForceString::TextEncoding encoding, TFStoryScript& tfs, bool bTailMerge)
+    {
+        int errparse = 0;
+        switch (encoding)
+        {
+            case TagForceString::ENC_RAW:
+            {
+                std::vector<std::string> strings;
+                std::vector<uint32_t> aliases;
+                errparse = TagForceString::ParseTxtRaw(txtPath, &strings, &aliases);
+                if (errparse >= 0)
+                    tfs.build(&strings, bTailMerge, &aliases);
+                break;
+            }
+
+            case TagForceString::ENC_UTF8:
+            {
+                std::vector<std::u8string> strings;
+                std::vector<uint32_t> aliases;
+                errparse = TagForceString::ParseTxtU8(txtPath, &strings, &aliases);
+                if (errparse >= 0)
+                    tfs.build(&strings, bTailMerge, &aliases);
+                break;
+            }
+
+            default:
+            {
+                std::vector<std::u16string> strings;
+                std::vector<uint32_t> aliases;
+                errparse = TagForceString::ParseTxtU16(txtPath, &strings, &aliases);
+                if (errparse >= 0)
+                    tfs.build(&strings, bTailMerge, &aliases);
+                break;
+            }
+        }
+
+        return errparse;
+    }
+
+    void GetImportPaths(const TxtEntry& txt, std::filesystem::path outFolder, std::filesystem::path& idxPath, std::filesystem::path& langPath)
+    {
+        std::u8string ext = txt.bCompressed ? u8".bin.gz" : u8".bin";
+        idxPath = outFolder / (txt.name + u8'I' + txt.lang + ext);
+        langPath = outFolder / (txt.name + u8'L' + txt.lang + ext);
+    }
+
+    int ImportTxt(const TxtEntry& txt, std::filesystem::path outFolder, TagForceString::TextEncoding encoding, bool bTailMerge, std::atomic<uintmax_t>* pSavedBytes, const ZLibWrapper::GzParams& gzParams)
+    {
+        TagForceString::ConOut() << "Processing: " << (char*)txt.name.c_str() << '\n'
+            << " <- " << txt.txtPath.string() << '\n';
+
+        // parse & build the data
+        TFStoryScript tfs;
+        int errparse = ParseAndBuild(txt.txtPath, encoding, tfs, bTailMerge);
+        if (errparse < 0)
+        {
+            TagForceString::ConErr() << "ERROR: Can't parse: " << txt.txtPath << '\n';
+            return errparse;
+        }
+
+        if (bTailMerge)
+        {
+            TagForceString::ConOut() << "Tail merging saved " << tfs.tailMergeSavings() << " bytes\n";
+            if (pSavedBytes)
+                *pSavedBytes += tfs.tailMergeSavings();
+        }
+
+        std::filesystem::path idxPath;
+        std::filesystem::path langPath;
+        GetImportPaths(txt, outFolder, idxPath, langPath);
+
+        if (txt.bCompressed)
+        {
+            TagForceString::ConOut() << " -> " << idxPath.string() << '\n';
+
+            try
+            {
+                Stats::Scope scope(Stats::STAGE_COMPRESS);
+                scope.addBytes(tfs.idxsize());
+                ZLibWrapper::packGzFile(tfs.idxptr(), tfs.idxsize(), idxPath, gzParams);
+            }
+            catch (const std::exception& e)
+            {
+                TagForceString::ConErr() << "ERROR: Can't compress data to: " << idxPath.string() << '\n';
+                TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+                return -3;
+            }
+
+            TagForceString::ConOut() << " -> " << langPath.string() << '\n';
+
+            try
+            {
+                Stats::Scope scope(Stats::STAGE_COMPRESS);
+                scope.addBytes(tfs.datasize());
+                ZLibWrapper::packGzFile(tfs.fileptr(), tfs.datasize(), langPath, gzParams);
+            }
+            catch (const std::exception& e)
+            {
+                TagForceString::ConErr() << "ERROR: Can't compress data to: " << langPath.string() << '\n';
+                TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+                return -3;
+            }
+        }
+        else
+        {
+            TagForceString::ConOut() << " -> " << idxPath.string() << '\n';
+            TagForceString::ConOut() << " -> " << langPath.string() << '\n';
+
+            try
+            {
+                tfs.exportFile(idxPath, langPath);
+            }
+            catch (const std::exception& e)
+            {
+                TagForceString::ConErr() << "ERROR: Failed to open files: " << idxPath.string() << " and " << langPath.string() << " for writing.\n";
+                TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+                return -2;
+            }
+        }
+
+        return 0;
+    }
+
+    int ImportFolder(std::filesystem::path inFolder, std::filesystem::path outFolder, TagForceString::TextEncoding encoding, unsigned int nJobs, bool bTailMerge, const ZLibWrapper::GzParams& gzParams, bool bIncremental)
+    {
+        if (!std::filesystem::exists(inFolder))
+        {
+            TagForceString::ConErr() << "ERROR: Folder " << inFolder.string() << " does not exist!\n";
+            return -1;
+        }
+
+        if (!std::filesystem::exists(outFolder))
+        {
+            try
+            {
+                std::filesystem::create_directory(outFolder);
+            }
+            catch (const std::exception& e)
+            {
+                TagForceString::ConErr() << "ERROR: Folder " << outFolder.string() << " could not be created!\n";
+                TagForceString::ConErr() << "Reason: " << e.what() << '\n';
+                return -2;
+            }
+        }
+
+        Stats::TraceSpan span("txt2fold", inFolder.string());
+        std::vector<TxtEntry> entries = FindTxtFiles(inFolder);
+        std::atomic<uintmax_t> savedBytes = 0;
+
+        std::unique_ptr<FolderCache::Cache> pCache;
+        if (bIncremental)
+            pCache = std::make_unique<FolderCache::Cache>(outFolder);
+        std::string settings = "txt2fold enc=" + std::to_string((int)encoding) + " tail=" + std::to_string((int)bTailMerge)
+            + " gz=" + std::to_string(gzParams.level) + ',' + std::to_string(gzParams.strategy) + ',' + std::to_string(gzParams.memLevel)
+            + ' ' + ZLibWrapper::defaultBackend().name();
+        std::atomic<size_t> upToDateCount = 0;
+
+        size_t failCount = RunJobs(entries.size(), nJobs, [&](size_t i)
+        {
+            const TxtEntry& txt = entries[i];
+            std::filesystem::path idxPath;
+            std::filesystem::path langPath;
+            GetImportPaths(txt, outFolder, idxPath, langPath);
+
+            return RunCached(pCache.get(), txt.name, settings, { txt.txtPath }, { idxPath, langPath }, upToDateCount, [&]
+            {
+                return ImportTxt(txt, outFolder, encoding, bTailMerge, &savedBytes, gzParams);
+            });
+        });
+
+        SaveCache(pCache.get(), upToDateCount, entries.size());
+
+        if (bTailMerge)
+            TagForceString::ConOut() << "Tail merging saved " << savedBytes << " bytes in total\n";
+
+        if (failCount)
+        {
+            TagForceString::ConErr() << "WARNING: " << failCount << " of " << entries.size() << " files failed to convert!\n";
+            return -3;
+        }
+
+        return 0;
+    }
+
+    int ImportFolderU16(std::filesystem::path inFolder, std::filesystem::path outFolder, unsigned int nJobs, bool bTailMerge, const ZLibWrapper::GzParams& gzParams, bool bIncremental)
+    {
+        return ImportFolder(inFolder, outFolder, TagForceString::ENC_UTF16, nJobs, bTailMerge, gzParams, bIncremental);
+    }
+
+    int ImportFolderU8(std::filesystem::path inFolder, std::filesystem::path outFolder, unsigned int nJobs, bool bTailMerge, const ZLibWrapper::GzParams& gzParams, bool bIncremental)
+    {
+        return ImportFolder(inFolder, outFolder, TagForceString::ENC_UTF8, nJobs, bTailMerge, gzParams, bIncremental);
+    }
+
+    int ImportFolderRaw(std::filesystem::path inFolder, std::filesystem::path outFolder, unsigned int nJobs, bool bTailMerge, const ZLibWrapper::GzParams& gzParams, bool bIncremental)
+    {
+        return ImportFolder(inFolder, outFolder, TagForceString::ENC_RAW, nJobs, bTailMerge, gzParams, bIncremental);
+    }
+}
\ No newline at end of file
@@ -5,232 +5,343 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include <span>
+#include <string_view>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <cerrno>
+#include "FileBuffer.hpp"
+#include "Stats.hpp"
 
 #ifndef TFSTRINGCLASSES_HDR
 #define TFSTRINGCLASSES_HDR
 
+//
+// Collects the strings of a resource into one data block, storing every unique string only once.
+// Duplicates are found through a flat open-addressing table. Its keys are offsets into the data block,
+// so a string is hashed once and copied nowhere but the output.
+// A buffer is meant to hold strings of a single kind (UTF-16, UTF-8 or raw).
+//
 class StringBuffer
 {
 public:
-	explicit StringBuffer() : offset(0) {}
+	explicit StringBuffer() : usedSlots(0) {}
 
-	uint32_t addString(const std::u16string& str)
+	//
+	// Makes room for a list of strings up front (as if there were no duplicates), so adding them doesn't regrow anything
+	//
+	template<typename StringT>
+	void reserve(const std::vector<StringT>& strings, bool bAligned = false)
 	{
-		auto iter = stringOffsetMap.find(str);
-		if (iter != stringOffsetMap.end())
+		size_t bytes = 0;
+		for (const auto& str : strings)
 		{
-			// String is a duplicate, return the offset of the original
-			return iter->second;
+			bytes += (str.length() + 1) * sizeof(typename StringT::value_type);
+			if (bAligned)
+				bytes += 3;
 		}
-		else {
-			// String is unique, add it to the buffer and update the offset
-			uint32_t currentOffset = offset;
-			stringOffsetMap[str] = currentOffset;
-			offset += static_cast<uint32_t>(str.length() * sizeof(char16_t)) + sizeof(char16_t); // Include null terminator
-
-			// Append the string to the buffer
-			buffer.insert(buffer.end(), str.begin(), str.end());
-			buffer.push_back(u'\0'); // Add null terminator
 
-			return currentOffset;
-		}
+		data.reserve(data.size() + bytes);
+		growTable(usedSlots + strings.size());
 	}
 
-	uint32_t addStringAligned(const std::u16string& str)
+	//
+	// Adds a list of strings and returns the offset of each one.
+	// With tail merging, a string that is the end of another one points into that string's tail instead of being stored again.
+	// savedBytes gets how much smaller that makes the data compared to plain deduplication.
+	// aliases (from the txt parser, may be null) names the string each entry shares. Aliased entries are never hashed,
+	// they just take the offset of the string they point at.
+	//
+	template<typename StringT>
+	std::vector<uint32_t> addStrings(const std::vector<StringT>& strings, bool bTailMerge, uintmax_t& savedBytes, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		auto iter = stringOffsetMap.find(str);
-		if (iter != stringOffsetMap.end())
-		{
-			// String is a duplicate, return the offset of the original
-			return iter->second;
-		}
-		else {
-			// String is unique, add it to the buffer and update the offset
-			uint32_t currentOffset = offset;
-			stringOffsetMap[str] = currentOffset;
-			uint32_t strsize = static_cast<uint32_t>(str.length() * sizeof(char16_t)) + sizeof(char16_t); // Include null terminator
-			offset += strsize;
+		using CharT = typename StringT::value_type;
 
-			uint32_t alignoffset = calculate_aligned_address(offset, 4);
+		Stats::Scope scope(Stats::STAGE_INTERN);
+		size_t startSlots = usedSlots;
 
+		reserve(strings);
+		savedBytes = 0;
 
-			// Append the string to the buffer
-			appendRawData(rawbuffer, (uint8_t*)str.data(), (str.length() * sizeof(char16_t)) + sizeof(char16_t));
+		std::vector<uint32_t> offsets;
+		offsets.reserve(strings.size());
+
+		auto isAlias = [aliases](size_t i) { return aliases && ((*aliases)[i] != i); };
 
-			uintmax_t alignbytes = alignoffset - offset;
-			offset += alignbytes;
-			strsize += alignbytes;
-			while (alignbytes)
+		if (!bTailMerge)
+		{
+			for (size_t i = 0; i < strings.size(); i++)
 			{
-				rawbuffer.push_back(0);
-				alignbytes--;
+				const StringT& str = strings[i];
+				offsets.push_back(isAlias(i) ? 0 : addBytes(str.data(), str.length() * sizeof(CharT), sizeof(CharT), false, nullptr));
 			}
-			
-			stringAlignSizesMap[str] = strsize;
 
-			return currentOffset;
+			resolveAliases(offsets, aliases);
+			Stats::Add(Stats::COUNTER_STRINGS_UNIQUE, usedSlots - startSlots);
+			return offsets;
 		}
-	}
 
-	uint32_t addString(const std::u8string& str)
-	{
-		auto iter = stringOffsetMapU8.find(str);
-		if (iter != stringOffsetMapU8.end()) {
-			// String is a duplicate, return the offset of the original
-			return iter->second;
+		// sorted by reversed content, every string sits right in front of the strings it is the tail of
+		std::vector<uint32_t> order;
+		order.reserve(strings.size());
+		for (size_t i = 0; i < strings.size(); i++)
+		{
+			if (!isAlias(i))
+				order.push_back(static_cast<uint32_t>(i));
 		}
-		else {
-			// String is unique, add it to the buffer and update the offset
-			uint32_t currentOffset = offset;
-			stringOffsetMapU8[str] = currentOffset;
-			offset += static_cast<uint32_t>(str.length()) + sizeof(char8_t); // Include null terminator
+		size_t count = order.size();
 
-			// Append the string to the buffer
-			u8buffer.insert(u8buffer.end(), str.begin(), str.end());
-			u8buffer.push_back('\0'); // Add null terminator
+		std::sort(order.begin(), order.end(), [&strings](uint32_t a, uint32_t b)
+		{
+			const StringT& sa = strings[a];
+			const StringT& sb = strings[b];
+			if (std::lexicographical_compare(sa.rbegin(), sa.rend(), sb.rbegin(), sb.rend()))
+				return true;
+			if (std::lexicographical_compare(sb.rbegin(), sb.rend(), sa.rbegin(), sa.rend()))
+				return false;
+			return a < b;
+		});
+
+		// walking back to front, a string takes over the host of the string it ends
+		std::vector<uint32_t> host(strings.size());
+		uintmax_t uniqueBytes = 0;
+		for (size_t i = count; i-- > 0;)
+		{
+			uint32_t cur = order[i];
+			const StringT& str = strings[cur];
+			host[cur] = cur;
+
+			bool bDuplicate = false;
+			if ((i + 1) < count)
+			{
+				const StringT& next = strings[order[i + 1]];
+				if ((str.length() <= next.length()) && std::equal(str.rbegin(), str.rend(), next.rbegin()))
+				{
+					host[cur] = host[order[i + 1]];
+					bDuplicate = (str.length() == next.length());
+				}
+			}
 
-			return currentOffset;
+			if (!bDuplicate)
+				uniqueBytes += (str.length() + 1) * sizeof(CharT);
 		}
-	}
 
-	uint32_t addStringAligned(const std::u8string& str)
-	{
-		auto iter = stringOffsetMapU8.find(str);
-		if (iter != stringOffsetMapU8.end())
+		// hosts are stored in the order they're first used
+		uint32_t startSize = dataSize();
+		std::vector<uint32_t> hostOffsets(strings.size(), EMPTY_SLOT);
+		for (size_t i = 0; i < strings.size(); i++)
 		{
-			// String is a duplicate, return the offset of the original
-			return iter->second;
-		}
-		else {
-			// String is unique, add it to the buffer and update the offset
-			uint32_t currentOffset = offset;
-			stringOffsetMapU8[str] = currentOffset;
-			uint32_t strsize = static_cast<uint32_t>(str.length() * sizeof(char8_t)) + sizeof(char8_t); // Include null terminator
-			offset += strsize;
-
-			uint32_t alignoffset = calculate_aligned_address(offset, 4);
-
-			// Append the string to the buffer
-			appendRawData(rawbuffer, (uint8_t*)str.data(), (str.size() * sizeof(char8_t)) + sizeof(char8_t));
-
-			uintmax_t alignbytes = alignoffset - offset;
-			offset += alignbytes;
-			strsize += alignbytes;
-			while (alignbytes)
+			if (isAlias(i))
 			{
-				rawbuffer.push_back(0);
-				alignbytes--;
+				offsets.push_back(0);
+				continue;
 			}
 
-			stringAlignSizesMapU8[str] = strsize;
+			uint32_t h = host[i];
+			const StringT& hostStr = strings[h];
+			if (hostOffsets[h] == EMPTY_SLOT)
+				hostOffsets[h] = addBytes(hostStr.data(), hostStr.length() * sizeof(CharT), sizeof(CharT), false, nullptr);
 
-			return currentOffset;
+			offsets.push_back(hostOffsets[h] + static_cast<uint32_t>((hostStr.length() - strings[i].length()) * sizeof(CharT)));
 		}
+
+		savedBytes = uniqueBytes - (dataSize() - startSize);
+		resolveAliases(offsets, aliases);
+		Stats::Add(Stats::COUNTER_STRINGS_UNIQUE, usedSlots - startSlots);
+		Stats::Add(Stats::COUNTER_TAIL_MERGE_SAVED, savedBytes);
+		return offsets;
 	}
 
-	uint32_t addStringRawAligned(const std::string& str)
+	uint32_t addString(const std::u16string& str)
 	{
-		auto iter = stringOffsetMapRaw.find(str);
-		if (iter != stringOffsetMapRaw.end())
-		{
-			// String is a duplicate, return the offset of the original
-			return iter->second;
-		}
-		else {
-			// String is unique, add it to the buffer and update the offset
-			uint32_t currentOffset = offset;
-			stringOffsetMapRaw[str] = currentOffset;
-			uint32_t strsize = static_cast<uint32_t>(str.length() * sizeof(char)) + sizeof(char); // Include null terminator
-			offset += strsize;
-
-			uint32_t alignoffset = calculate_aligned_address(offset, 4);
-
-			// Append the string to the buffer
-			appendRawData(rawbuffer, (uint8_t*)str.data(), (str.size() * sizeof(char)) + sizeof(char));
-
-			uintmax_t alignbytes = alignoffset - offset;
-			offset += alignbytes;
-			strsize += alignbytes;
-			while (alignbytes)
-			{
-				rawbuffer.push_back(0);
-				alignbytes--;
-			}
+		return addBytes(str.data(), str.length() * sizeof(char16_t), sizeof(char16_t), false, nullptr);
+	}
 
-			stringAlignSizesMapRaw[str] = strsize;
+	//
+	// Adds a string padded to 4 bytes and gets its padded size along with the offset
+	//
+	uint32_t addStringAligned(const std::u16string& str, uint32_t& alignedSize)
+	{
+		return addBytes(str.data(), str.length() * sizeof(char16_t), sizeof(char16_t), true, &alignedSize);
+	}
 
-			return currentOffset;
-		}
+	uint32_t addString(const std::u8string& str)
+	{
+		return addBytes(str.data(), str.length(), sizeof(char8_t), false, nullptr);
 	}
 
-	uint32_t addStringRaw(const std::string& str)
+	uint32_t addStringAligned(const std::u8string& str, uint32_t& alignedSize)
 	{
-		auto iter = stringOffsetMapRaw.find(str);
-		if (iter != stringOffsetMapRaw.end()) {
-			// String is a duplicate, return the offset of the original
-			return iter->second;
-		}
-		else {
-			// String is unique, add it to the buffer and update the offset
-			uint32_t currentOffset = offset;
-			stringOffsetMapRaw[str] = currentOffset;
-			offset += static_cast<uint32_t>(str.length()) + sizeof(char); // Include null terminator
+		return addBytes(str.data(), str.length(), sizeof(char8_t), true, &alignedSize);
+	}
 
-			// Append the string to the buffer
-			appendRawData(rawbuffer, (uint8_t*)str.data(), (str.size() * sizeof(char)) + sizeof(char));
+	uint32_t addStringRawAligned(const std::string& str, uint32_t& alignedSize)
+	{
+		return addBytes(str.data(), str.length(), sizeof(char), true, &alignedSize);
+	}
 
-			return currentOffset;
-		}
+	uint32_t addStringRaw(const std::string& str)
+	{
+		return addBytes(str.data(), str.length(), sizeof(char), false, nullptr);
 	}
 
 	// Get the buffer data
 	const char16_t* getData()
 	{
-		return buffer.data();
+		return reinterpret_cast<const char16_t*>(data.data());
 	}
 
 	const char8_t* u8GetData()
 	{
-		return u8buffer.data();
+		return reinterpret_cast<const char8_t*>(data.data());
 	}
 
 	const uint8_t* rawGetData()
 	{
-		return rawbuffer.data();
+		return data.data();
 	}
 
 	uint32_t dataSize()
 	{
-		return offset;
+		return static_cast<uint32_t>(data.size());
 	}
 
-	uint32_t getAlignStrSize(std::u16string str)
+	// Number of distinct strings stored so far
+	size_t uniqueCount() const
 	{
-		return stringAlignSizesMap[str];
+		return usedSlots;
 	}
 
-	uint32_t getAlignStrSize(std::u8string str)
+private:
+	//
+	// Gives aliased entries the offset of the entry they point at
+	//
+	static void resolveAliases(std::vector<uint32_t>& offsets, const std::vector<uint32_t>* aliases)
 	{
-		return stringAlignSizesMapU8[str];
+		if (!aliases)
+			return;
+
+		for (size_t i = 0; i < offsets.size(); i++)
+			offsets[i] = offsets[(*aliases)[i]];
 	}
 
-	uint32_t getAlignStrSize(std::string str)
+	struct Slot
+	{
+		uint32_t hash;    // Low 32 bits of the string's hash, enough to place it in the table
+		uint32_t offset;  // Offset of the string in the data block, EMPTY_SLOT if unused
+		uint32_t length;  // String length in bytes, without the null terminator
+		uint32_t size;    // Bytes taken in the data block, including null terminator and padding
+	};
+
+	static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+	std::vector<uint8_t> data;  // Buffer to store the strings
+	std::vector<Slot> slots;    // Power of two sized, kept at most half full
+	size_t usedSlots;
+
+	static uint64_t mix(uint64_t x)
 	{
-		return stringAlignSizesMapRaw[str];
+		x ^= x >> 33;
+		x *= 0xFF51AFD7ED558CCDull;
+		x ^= x >> 33;
+		x *= 0xC4CEB9FE1A85EC53ull;
+		x ^= x >> 33;
+		return x;
 	}
 
-private:
-	std::vector<char16_t> buffer;  // Buffer to store the strings
-	std::vector<char8_t> u8buffer;  // Buffer to store the strings
-	std::vector<uint8_t> rawbuffer;  // Buffer to store the strings
-	std::unordered_map<std::u16string, uint32_t> stringOffsetMap;  // Map to store string offsets
-	std::unordered_map<std::u8string, uint32_t> stringOffsetMapU8;  // Map to store string offsets
-	std::unordered_map<std::string, uint32_t> stringOffsetMapRaw;  // Map to store string offsets
-	std::unordered_map<std::u16string, uint32_t> stringAlignSizesMap;
-	std::unordered_map<std::u8string, uint32_t> stringAlignSizesMapU8;
-	std::unordered_map<std::string, uint32_t> stringAlignSizesMapRaw;
-
-	uint32_t offset;  // Current offset in the buffer
+	static uint64_t hashBytes(const uint8_t* bytes, size_t length)
+	{
+		uint64_t h = 0x9E3779B97F4A7C15ull ^ length;
+
+		while (length >= sizeof(uint64_t))
+		{
+			uint64_t k;
+			memcpy(&k, bytes, sizeof(uint64_t));
+			h = (h ^ mix(k)) * 0x9E3779B97F4A7C15ull;
+			bytes += sizeof(uint64_t);
+			length -= sizeof(uint64_t);
+		}
+
+		if (length)
+		{
+			uint64_t k = 0;
+			memcpy(&k, bytes, length);
+			h = (h ^ mix(k)) * 0x9E3779B97F4A7C15ull;
+		}
+
+		return mix(h);
+	}
+
+	//
+	// Resizes the table for at least the given number of strings. Slots are moved by their stored hash.
+	//
+	void growTable(size_t stringCount)
+	{
+		size_t newCount = 16;
+		while (newCount < (stringCount * 2))
+			newCount *= 2;
+
+		if (newCount <= slots.size())
+			return;
+
+		std::vector<Slot> oldSlots = std::move(slots);
+		slots.assign(newCount, Slot{ 0, EMPTY_SLOT, 0, 0 });
+
+		size_t mask = newCount - 1;
+		for (const Slot& slot : oldSlots)
+		{
+			if (slot.offset == EMPTY_SLOT)
+				continue;
+
+			size_t index = slot.hash & mask;
+			while (slots[index].offset != EMPTY_SLOT)
+				index = (index + 1) & mask;
+
+			slots[index] = slot;
+		}
+	}
+
+	uint32_t addBytes(const void* str, size_t length, size_t termSize, bool bAligned, uint32_t* pSize)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(str);
+		uint32_t hash = static_cast<uint32_t>(hashBytes(bytes, length));
+
+		if (((usedSlots + 1) * 2) > slots.size())
+			growTable(usedSlots + 1);
+
+		size_t mask = slots.size() - 1;
+		size_t index = hash & mask;
+		while (slots[index].offset != EMPTY_SLOT)
+		{
+			const Slot& slot = slots[index];
+			if ((slot.hash == hash) && (slot.length == length) && (memcmp(&data[slot.offset], bytes, length) == 0))
+			{
+				// String is a duplicate, return the offset of the original
+				if (pSize)
+					*pSize = slot.size;
+				return slot.offset;
+			}
+
+			index = (index + 1) & mask;
+		}
+
+		// String is unique, add it to the buffer (the new bytes are zeroed, which covers null terminator and padding)
+		uint32_t currentOffset = static_cast<uint32_t>(data.size());
+		uint32_t strsize = static_cast<uint32_t>(length + termSize);
+		if (bAligned)
+			strsize = static_cast<uint32_t>(calculate_aligned_address(currentOffset + strsize, 4) - currentOffset);
+
+		data.resize(currentOffset + strsize);
+		memcpy(&data[currentOffset], bytes, length);
+
+		slots[index] = Slot{ hash, currentOffset, static_cast<uint32_t>(length), strsize };
+		usedSlots++;
+
+		if (pSize)
+			*pSize = strsize;
+		return currentOffset;
+	}
 
 	uintptr_t calculate_aligned_address(uintptr_t address, size_t alignment) 
 	{
@@ -247,16 +358,76 @@ private:
 
 		return aligned_address;
 	}
+};
+
+//
+// Length of a null terminated string in code units. Stops at the end of the buffer if the terminator is missing.
+//
+template<typename CharT>
+inline uint32_t BoundedStrLength(const uint8_t* str, const uint8_t* end)
+{
+	if (str >= end)
+		return 0;
+
+	size_t maxLength = (end - str) / sizeof(CharT);
+	const CharT* start = reinterpret_cast<const CharT*>(str);
+	const CharT* terminator = std::char_traits<CharT>::find(start, maxLength, CharT());
+	return static_cast<uint32_t>(terminator ? (terminator - start) : maxLength);
+}
+
+//
+// Side index entry of a resource string
+//
+struct StringEntry
+{
+	uint32_t offset;  // The string's entry in the resource's table as stored: bytes into the data (strtbl), code units into the lang data (story script), bytes into the file (text resource)
+	uint32_t length;  // In code units, without the null terminator
+	uint32_t first;   // First entry with the same data (deduplicated strings), its own index if there is none before it
+};
+
+//
+// Builds the side index of a resource in one pass. keyOf(i) identifies the data entry i points to (entries with the same key
+// share their string), its low 32 bits are the table value stored as the offset. measure(i) gives its length.
+// Shared strings are only measured once, the entries after the first copy it.
+//
+template<typename KeyFn, typename MeasureFn>
+void BuildStringIndex(size_t count, KeyFn keyOf, MeasureFn measure, std::vector<StringEntry>& index)
+{
+	static constexpr uint32_t EMPTY = UINT32_MAX;
+
+	index.resize(count);
+
+	// flat open-addressing table from key to the first entry with it, at most half full
+	size_t tableSize = 16;
+	while (tableSize < (count * 2))
+		tableSize <<= 1;
+	std::vector<uint32_t> table(tableSize, EMPTY);
+	std::vector<uint64_t> keys(count);
+	size_t mask = tableSize - 1;
 
-	void appendRawData(std::vector<uint8_t>& destination, const uint8_t* source, size_t size) 
+	for (size_t i = 0; i < count; i++)
 	{
-		size_t currentSize = destination.size();
+		uint64_t key = keyOf(i);
+		keys[i] = key;
 
-		destination.resize(currentSize + size);
+		uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+		size_t slot = static_cast<size_t>(hash ^ (hash >> 32)) & mask;
+		while ((table[slot] != EMPTY) && (keys[table[slot]] != key))
+			slot = (slot + 1) & mask;
 
-		std::copy(source, source + size, destination.begin() + currentSize);
+		uint32_t offset = static_cast<uint32_t>(key);
+		if (table[slot] == EMPTY)
+		{
+			table[slot] = static_cast<uint32_t>(i);
+			index[i] = StringEntry{ offset, measure(i), static_cast<uint32_t>(i) };
+		}
+		else
+		{
+			const StringEntry& first = index[table[slot]];
+			index[i] = StringEntry{ offset, first.length, first.first };
+		}
 	}
-};
+}
 
 class YgStringResource
 {
@@ -271,6 +442,7 @@ private:
 #pragma pack(pop)
 
 	StrHdr* hdr;
+	FileBuffer fbuf;
 	uint8_t* filebuffer;
 	uint32_t* ptrTable;
 	uintptr_t ptrData;
@@ -279,6 +451,10 @@ private:
 	uintmax_t fileSize;
 
 	uint32_t nulldata;
+	uintmax_t tailMergeSaved;  // Bytes saved by tail merging in the last build
+
+	std::vector<StringEntry> index16;  // Side index for reading the strings as UTF-16, empty until first used
+	std::vector<StringEntry> index8;   // Same for 8-bit / raw strings
 
 	uintptr_t GetStrPtr(int index)
 	{
@@ -294,6 +470,21 @@ private:
 		return result;
 	}
 
+	template<typename CharT>
+	const std::vector<StringEntry>& buildIndex(std::vector<StringEntry>& index)
+	{
+		if (index.empty() && count())
+		{
+			const uint8_t* end = filebuffer + fileSize;
+			BuildStringIndex(count(),
+				[this](size_t i) { return (uint64_t)ptrTable[i]; },
+				[this, end](size_t i) { return BoundedStrLength<CharT>(reinterpret_cast<const uint8_t*>(GetStrPtr((int)i)), end); },
+				index);
+		}
+
+		return index;
+	}
+
 public:
 
 	wchar_t* c_wstr(int index)
@@ -324,11 +515,48 @@ public:
 		return reinterpret_cast<char*>(GetStrPtr(index));
 	}
 
+	//
+	// Side index of the strings when read as UTF-16 / 8-bit, built on first use after a load or build.
+	// Entries whose first isn't their own index share the string of that earlier entry.
+	//
+	const std::vector<StringEntry>& stringIndex16()
+	{
+		return buildIndex<char16_t>(index16);
+	}
+
+	const std::vector<StringEntry>& stringIndex8()
+	{
+		return buildIndex<char8_t>(index8);
+	}
+
+	//
+	// Views of a string without copying it, bounded by the end of the data. Out of range indices give an empty view.
+	// They use the side index, which is built once per character width on first use after a load or build.
+	//
+	std::u16string_view view16(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::u16string_view();
+		return std::u16string_view(c_u16str(index), buildIndex<char16_t>(index16)[index].length);
+	}
+
+	std::u8string_view view8(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::u8string_view();
+		return std::u8string_view(c_u8str(index), buildIndex<char8_t>(index8)[index].length);
+	}
+
+	std::string_view viewRaw(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::string_view();
+		return std::string_view(c_str(index), buildIndex<char>(index8)[index].length);
+	}
+
 	std::u16string u16string(int index)
 	{
-		if (index >= hdr->count)
-			return std::u16string();
-		return std::u16string(c_u16str(index));
+		return std::u16string(view16(index));
 	}
 
 	std::wstring wstring(int index)
@@ -340,21 +568,25 @@ public:
 
 	std::u8string u8string(int index)
 	{
-		if (index >= hdr->count)
-			return std::u8string();
-		return std::u8string(c_u8str(index));
+		return std::u8string(view8(index));
 	}
 
 	std::string string(int index)
 	{
-		if (index >= hdr->count)
-			return std::string();
-		return std::string(c_str(index));
+		return std::string(viewRaw(index));
 	}
 
 	int count()
 	{
-		return hdr->count;
+		return hdr ? hdr->count : 0;
+	}
+
+	//
+	// Bytes the last build saved by tail merging
+	//
+	uintmax_t tailMergeSavings()
+	{
+		return tailMergeSaved;
 	}
 
 	uintmax_t tblsize()
@@ -388,50 +620,36 @@ public:
 	}
 
 	//
-	// Load a string resource from a file
+	// Load a string resource from a file (memory mapped where supported)
 	//
 	void openFile(std::filesystem::path filename)
 	{
-		std::ifstream ifile;
-		try
-		{
-			ifile.open(filename, std::ios::binary);
-			if (!ifile.is_open())
-			{
-				filebuffer = nullptr;
-				throw std::runtime_error(strerror(errno));
-			}
-		}
-		catch (const std::exception& e)
-		{
-			throw e;
-		}
+		Stats::Scope scope(Stats::STAGE_OPEN);
+		index16.clear();
+		index8.clear();
 
+		filebuffer = nullptr;
+		fbuf.openFile(filename);
 
-		uintmax_t filesize = 0;
-		try
-		{
-			filesize = std::filesystem::file_size(filename);
-		}
-		catch (const std::exception& e)
+		filebuffer = fbuf.data();
+		uintmax_t filesize = fbuf.size();
+
+		// the header and the whole pointer table have to be in the file, the strings are checked as they're read
+		hdr = (StrHdr*)filebuffer;
+		if ((filesize < sizeof(StrHdr)) || (hdr->tblstart > filesize) || (hdr->datastart > filesize)
+			|| (((uintmax_t)hdr->count * sizeof(uint32_t)) > (filesize - hdr->tblstart)))
 		{
-			ifile.close();
-			throw e;
+			hdr = nullptr;
+			filebuffer = nullptr;
+			throw std::runtime_error("YgStringResource header doesn't match the file size!");
 		}
 
-		if (filebuffer)
-			free(filebuffer);
-
-		filebuffer = (uint8_t*)malloc(filesize);
-		ifile.read((char*)filebuffer, filesize);
-		ifile.close();
-
-		hdr = (StrHdr*)filebuffer;
 		ptrTable = reinterpret_cast<uint32_t*>(&filebuffer[hdr->tblstart]);
 		ptrData = reinterpret_cast<uintptr_t>(&filebuffer[hdr->datastart]);
 		dataSize = filesize - hdr->datastart;
 		tblSize = hdr->datastart - hdr->tblstart;
 		fileSize = filesize;
+		scope.addBytes(filesize);
 	}
 
 	//
@@ -439,6 +657,8 @@ public:
 	//
 	void exportFile(std::filesystem::path filename)
 	{
+		Stats::Scope scope(Stats::STAGE_WRITE);
+
 		if (filebuffer == nullptr)
 		{
 			throw std::runtime_error("YgStringResource filebuffer is null!");
@@ -459,6 +679,7 @@ public:
 		}
 
 		ofile.write((char*)filebuffer, fileSize);
+		scope.addBytes(fileSize);
 
 		ofile.flush();
 		ofile.close();
@@ -466,11 +687,13 @@ public:
 
 	//
 	// Builds a string resource out of a UTF-16 string vector
+	// Entries that aliases (from the txt parser) points elsewhere share that string without it being looked up again.
 	//
-	void build(std::vector<std::u16string>* strings)
+	void build(std::vector<std::u16string>* strings, bool bTailMerge = false, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (filebuffer)
-			free(filebuffer);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// generate the header
 		StrHdr strhdr;
@@ -479,17 +702,11 @@ public:
 		strhdr.datastart = sizeof(StrHdr) + (strings->size() * sizeof(uint32_t));
 
 		StringBuffer stringBuffer;
-		std::vector<uint32_t> offsets;
-
-		for (const auto& str : *strings)
-		{
-			uint32_t currentOffset = stringBuffer.addString(str);
-			offsets.push_back(currentOffset);
-		}
+		std::vector<uint32_t> offsets = stringBuffer.addStrings(*strings, bTailMerge, tailMergeSaved, aliases);
 
 		// new buffer
 		uintmax_t newsize = strhdr.datastart + stringBuffer.dataSize();
-		filebuffer = (uint8_t*)malloc(newsize);
+		filebuffer = fbuf.allocate(newsize);
 
 		// copy data
 		uintmax_t cursor = 0;
@@ -506,15 +723,17 @@ public:
 		dataSize = newsize - hdr->datastart;
 		tblSize = hdr->datastart - hdr->tblstart;
 		fileSize = newsize;
+		scope.addBytes(newsize);
 	}
 
 	//
 	// Builds a string resource out of a UTF-8 string vector
 	//
-	void build(std::vector<std::u8string>* strings)
+	void build(std::vector<std::u8string>* strings, bool bTailMerge = false, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (filebuffer)
-			free(filebuffer);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// generate the header
 		StrHdr strhdr;
@@ -523,17 +742,11 @@ public:
 		strhdr.datastart = sizeof(StrHdr) + (strings->size() * sizeof(uint32_t));
 
 		StringBuffer stringBuffer;
-		std::vector<uint32_t> offsets;
-
-		for (const auto& str : *strings)
-		{
-			uint32_t currentOffset = stringBuffer.addString(str);
-			offsets.push_back(currentOffset);
-		}
+		std::vector<uint32_t> offsets = stringBuffer.addStrings(*strings, bTailMerge, tailMergeSaved, aliases);
 
 		// new buffer
 		uintmax_t newsize = strhdr.datastart + stringBuffer.dataSize();
-		filebuffer = (uint8_t*)malloc(newsize);
+		filebuffer = fbuf.allocate(newsize);
 
 		// copy data
 		uintmax_t cursor = 0;
@@ -550,15 +763,17 @@ public:
 		dataSize = newsize - hdr->datastart;
 		tblSize = hdr->datastart - hdr->tblstart;
 		fileSize = newsize;
+		scope.addBytes(newsize);
 	}
 
 	//
 	// Builds a string resource out of a raw string vector
 	//
-	void build(std::vector<std::string>* strings)
+	void build(std::vector<std::string>* strings, bool bTailMerge = false, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (filebuffer)
-			free(filebuffer);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// generate the header
 		StrHdr strhdr;
@@ -567,17 +782,11 @@ public:
 		strhdr.datastart = sizeof(StrHdr) + (strings->size() * sizeof(uint32_t));
 
 		StringBuffer stringBuffer;
-		std::vector<uint32_t> offsets;
-
-		for (const auto& str : *strings)
-		{
-			uint32_t currentOffset = stringBuffer.addStringRaw(str);
-			offsets.push_back(currentOffset);
-		}
+		std::vector<uint32_t> offsets = stringBuffer.addStrings(*strings, bTailMerge, tailMergeSaved, aliases);
 
 		// new buffer
 		uintmax_t newsize = strhdr.datastart + stringBuffer.dataSize();
-		filebuffer = (uint8_t*)malloc(newsize);
+		filebuffer = fbuf.allocate(newsize);
 
 		// copy data
 		uintmax_t cursor = 0;
@@ -594,6 +803,7 @@ public:
 		dataSize = newsize - hdr->datastart;
 		tblSize = hdr->datastart - hdr->tblstart;
 		fileSize = newsize;
+		scope.addBytes(newsize);
 	}
 
 	YgStringResource()
@@ -606,18 +816,17 @@ public:
 		dataSize = 0;
 		fileSize = 0;
 		tblSize = 0;
+		tailMergeSaved = 0;
 	}
 
-	~YgStringResource()
-	{
-		if (filebuffer)
-			free(filebuffer);
-	}
 };
 
 class TFStoryScript
 {
 private:
+	FileBuffer idxBuf;
+	FileBuffer langBuf;
+
 	uint32_t* strIdx;
 	size_t strCount;
 
@@ -625,6 +834,10 @@ private:
 	uintmax_t fileSizeLang;
 
 	uint32_t nulldata;
+	uintmax_t tailMergeSaved;  // Bytes saved by tail merging in the last build
+
+	std::vector<StringEntry> index16;  // Side index for reading the strings as UTF-16, empty until first used
+	std::vector<StringEntry> index8;   // Same for 8-bit / raw strings
 
 	uintptr_t GetStrPtr(int index)
 	{
@@ -668,6 +881,27 @@ private:
 		return result;
 	}
 
+	template<typename CharT>
+	const std::vector<StringEntry>& buildIndex(std::vector<StringEntry>& index)
+	{
+		// strCount comes from the size of the idx data, so every entry is in memory
+		if (index.empty() && strCount)
+		{
+			// the index counts in code units, the same value means the same string for either width
+			const uint8_t* end = langBuffer + fileSizeLang;
+			BuildStringIndex(strCount,
+				[this](size_t i) { return (uint64_t)strIdx[i]; },
+				[this, end](size_t i)
+				{
+					uintptr_t str = (sizeof(CharT) == sizeof(char16_t)) ? GetStrPtr((int)i) : GetStrPtrU8((int)i);
+					return BoundedStrLength<CharT>(reinterpret_cast<const uint8_t*>(str), end);
+				},
+				index);
+		}
+
+		return index;
+	}
+
 public:
 	wchar_t* c_wstr(int index)
 	{
@@ -697,11 +931,48 @@ public:
 		return reinterpret_cast<char*>(GetStrPtrRaw(index));
 	}
 
+	//
+	// Side index of the strings when read as UTF-16 / 8-bit, built on first use after a load or build.
+	// Entries whose first isn't their own index share the string of that earlier entry.
+	//
+	const std::vector<StringEntry>& stringIndex16()
+	{
+		return buildIndex<char16_t>(index16);
+	}
+
+	const std::vector<StringEntry>& stringIndex8()
+	{
+		return buildIndex<char8_t>(index8);
+	}
+
+	//
+	// Views of a string without copying it, bounded by the end of the data. Out of range indices give an empty view.
+	// They use the side index, which is built once per character width on first use after a load or build.
+	//
+	std::u16string_view view16(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::u16string_view();
+		return std::u16string_view(c_u16str(index), buildIndex<char16_t>(index16)[index].length);
+	}
+
+	std::u8string_view view8(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::u8string_view();
+		return std::u8string_view(c_u8str(index), buildIndex<char8_t>(index8)[index].length);
+	}
+
+	std::string_view viewRaw(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::string_view();
+		return std::string_view(c_str(index), buildIndex<char>(index8)[index].length);
+	}
+
 	std::u16string u16string(int index)
 	{
-		if (index >= strCount)
-			return std::u16string();
-		return std::u16string(c_u16str(index));
+		return std::u16string(view16(index));
 	}
 
 	std::wstring wstring(int index)
@@ -713,16 +984,12 @@ public:
 
 	std::u8string u8string(int index)
 	{
-		if (index >= strCount)
-			return std::u8string();
-		return std::u8string(c_u8str(index));
+		return std::u8string(view8(index));
 	}
 
 	std::string string(int index)
 	{
-		if (index >= strCount)
-			return std::string();
-		return std::string(c_str(index));
+		return std::string(viewRaw(index));
 	}
 
 	int count()
@@ -730,6 +997,14 @@ public:
 		return strCount;
 	}
 
+	//
+	// Bytes the last build saved by tail merging
+	//
+	uintmax_t tailMergeSavings()
+	{
+		return tailMergeSaved;
+	}
+
 	uintmax_t datasize()
 	{
 		return fileSizeLang;
@@ -751,86 +1026,66 @@ public:
 	}
 
 	//
-	// Load a story script index + lang pair from their files
+	// Load a story script index + lang pair from their files (memory mapped where supported)
 	//
 	void openFile(std::filesystem::path idxFilename, std::filesystem::path langFilename)
 	{
-		std::ifstream idxfile;
+		Stats::Scope scope(Stats::STAGE_OPEN);
+		index16.clear();
+		index8.clear();
+
+		langBuffer = nullptr;
+		strIdx = nullptr;
+		strCount = 0;
+		fileSizeLang = 0;
+
 		try
 		{
-			idxfile.open(idxFilename, std::ios::binary);
-			if (!idxfile.is_open())
-			{
-				langBuffer = nullptr;
-				strIdx = nullptr;
-				std::string excstr = "idx file failure: ";
-				excstr += strerror(errno);
-				throw std::runtime_error(excstr);
-			}
+			idxBuf.openFile(idxFilename);
 		}
 		catch (const std::exception& e)
 		{
-			throw e;
+			std::string excstr = "idx file failure: ";
+			excstr += e.what();
+			throw std::runtime_error(excstr);
 		}
 
-		std::ifstream langfile;
 		try
 		{
-			langfile.open(langFilename, std::ios::binary);
-			if (!langfile.is_open())
-			{
-				langBuffer = nullptr;
-				strIdx = nullptr;
-				std::string excstr = "lang file failure: ";
-				excstr += strerror(errno);
-				throw std::runtime_error(strerror(errno));
-			}
+			langBuf.openFile(langFilename);
 		}
 		catch (const std::exception& e)
 		{
-			throw e;
+			std::string excstr = "lang file failure: ";
+			excstr += e.what();
+			throw std::runtime_error(excstr);
 		}
 
-		if (langBuffer)
-			free(langBuffer);
-
-		if (strIdx)
-			free(strIdx);
+		strIdx = reinterpret_cast<uint32_t*>(idxBuf.data());
+		strCount = idxBuf.size() / sizeof(uint32_t);
 
-		uintmax_t idxfilesize = 0;
-		try
-		{
-			idxfilesize = std::filesystem::file_size(idxFilename);
-		}
-		catch (const std::exception& e)
-		{
-			idxfile.close();
-			langfile.close();
-			throw e;
-		}
+		langBuffer = langBuf.data();
+		fileSizeLang = langBuf.size();
+		scope.addBytes(idxBuf.size() + fileSizeLang);
+	}
 
-		strIdx = (uint32_t*)malloc(idxfilesize);
-		idxfile.read((char*)strIdx, idxfilesize);
-		idxfile.close();
-		strCount = idxfilesize / sizeof(uint32_t);
+	//
+	// Use a story script index + lang pair that's already in memory (e.g. decompressed from .gz files).
+	// The data isn't copied, so it has to stay alive for as long as this object uses it.
+	//
+	void openMemory(std::span<uint8_t> idxSpan, std::span<uint8_t> langSpan)
+	{
+		index16.clear();
+		index8.clear();
 
-		uintmax_t langfilesize = 0;
-		try
-		{
-			langfilesize = std::filesystem::file_size(langFilename);
-		}
-		catch (const std::exception& e)
-		{
-			langfile.close();
-			idxfile.close();
-			throw e;
-		}
+		idxBuf.borrow(idxSpan.data(), idxSpan.size());
+		langBuf.borrow(langSpan.data(), langSpan.size());
 
-		langBuffer = (uint8_t*)malloc(langfilesize);
-		langfile.read((char*)langBuffer, langfilesize);
-		langfile.close();
+		strIdx = reinterpret_cast<uint32_t*>(idxBuf.data());
+		strCount = idxBuf.size() / sizeof(uint32_t);
 
-		fileSizeLang = langfilesize;
+		langBuffer = langBuf.data();
+		fileSizeLang = langBuf.size();
 	}
 
 	//
@@ -838,6 +1093,8 @@ public:
 	//
 	void exportFile(std::filesystem::path idxFilename, std::filesystem::path langFilename)
 	{
+		Stats::Scope scope(Stats::STAGE_WRITE);
+
 		if (langBuffer == nullptr)
 		{
 			throw std::runtime_error("TFStoryScript langBuffer is null!");
@@ -886,6 +1143,7 @@ public:
 		}
 
 		langfile.write((char*)langBuffer, fileSizeLang);
+		scope.addBytes(idxsize() + fileSizeLang);
 
 		langfile.flush();
 		langfile.close();
@@ -893,26 +1151,24 @@ public:
 
 	//
 	// Builds story script data out of a UTF-16 string vector
+	// Entries that aliases (from the txt parser) points elsewhere share that string without it being looked up again.
 	//
-	void build(std::vector<std::u16string>* strings)
+	void build(std::vector<std::u16string>* strings, bool bTailMerge = false, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (langBuffer)
-			free(langBuffer);
-
-		if (strIdx)
-			free(strIdx);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// index buffer
 		strCount = strings->size();
-		strIdx = (uint32_t*)malloc(strCount * sizeof(uint32_t));
+		strIdx = reinterpret_cast<uint32_t*>(idxBuf.allocate(strCount * sizeof(uint32_t)));
 
 		StringBuffer stringBuffer;
-		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> offsets = stringBuffer.addStrings(*strings, bTailMerge, tailMergeSaved, aliases);
 
 		int sc = 0;
-		for (const auto& str : *strings)
+		for (uint32_t currentOffset : offsets)
 		{
-			uint32_t currentOffset = stringBuffer.addString(str);
 			if (currentOffset == 0)
 				strIdx[sc] = 0;
 			else
@@ -922,87 +1178,84 @@ public:
 
 		// lang buffer
 		uintmax_t newsize = stringBuffer.dataSize();
-		langBuffer = (uint8_t*)malloc(newsize);
+		langBuffer = langBuf.allocate(newsize);
 
 		// copy data
 		memcpy(langBuffer, stringBuffer.getData(), newsize);
 
 		// update ptrs
 		fileSizeLang = newsize;
+		scope.addBytes(idxsize() + newsize);
 	}
 
 	//
 	// Builds story script data out of a UTF-8 string vector
 	//
-	void build(std::vector<std::u8string>* strings)
+	void build(std::vector<std::u8string>* strings, bool bTailMerge = false, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (langBuffer)
-			free(langBuffer);
-
-		if (strIdx)
-			free(strIdx);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// index buffer
 		strCount = strings->size();
-		strIdx = (uint32_t*)malloc(strCount * sizeof(uint32_t));
+		strIdx = reinterpret_cast<uint32_t*>(idxBuf.allocate(strCount * sizeof(uint32_t)));
 
 		StringBuffer stringBuffer;
-		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> offsets = stringBuffer.addStrings(*strings, bTailMerge, tailMergeSaved, aliases);
 
 		int sc = 0;
-		for (const auto& str : *strings)
+		for (uint32_t currentOffset : offsets)
 		{
-			uint32_t currentOffset = stringBuffer.addString(str);
 			strIdx[sc] = currentOffset;
 			sc++;
 		}
 
 		// lang buffer
 		uintmax_t newsize = stringBuffer.dataSize();
-		langBuffer = (uint8_t*)malloc(newsize);
+		langBuffer = langBuf.allocate(newsize);
 
 		// copy data
 		memcpy(langBuffer, stringBuffer.u8GetData(), newsize);
 
 		// update ptrs
 		fileSizeLang = newsize;
+		scope.addBytes(idxsize() + newsize);
 	}
 
 	//
 	// Builds story script data out of a raw string vector
 	//
-	void build(std::vector<std::string>* strings)
+	void build(std::vector<std::string>* strings, bool bTailMerge = false, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (langBuffer)
-			free(langBuffer);
-
-		if (strIdx)
-			free(strIdx);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// index buffer
 		strCount = strings->size();
-		strIdx = (uint32_t*)malloc(strCount * sizeof(uint32_t));
+		strIdx = reinterpret_cast<uint32_t*>(idxBuf.allocate(strCount * sizeof(uint32_t)));
 
 		StringBuffer stringBuffer;
-		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> offsets = stringBuffer.addStrings(*strings, bTailMerge, tailMergeSaved, aliases);
 
 		int sc = 0;
-		for (const auto& str : *strings)
+		for (uint32_t currentOffset : offsets)
 		{
-			uint32_t currentOffset = stringBuffer.addStringRaw(str);
 			strIdx[sc] = currentOffset;
 			sc++;
 		}
 
 		// lang buffer
 		uintmax_t newsize = stringBuffer.dataSize();
-		langBuffer = (uint8_t*)malloc(newsize);
+		langBuffer = langBuf.allocate(newsize);
 
 		// copy data
 		memcpy(langBuffer, stringBuffer.rawGetData(), newsize);
 
 		// update ptrs
 		fileSizeLang = newsize;
+		scope.addBytes(idxsize() + newsize);
 	}
 
 	TFStoryScript()
@@ -1012,15 +1265,9 @@ public:
 		langBuffer = nullptr;
 		fileSizeLang = 0;
 		nulldata = 0;
+		tailMergeSaved = 0;
 	}
 
-	~TFStoryScript()
-	{
-		if (langBuffer)
-			free(langBuffer);
-		if (strIdx)
-			free(strIdx);
-	}
 };
 
 //
@@ -1043,6 +1290,7 @@ private:
 
 	TxtItem* items;
 	uintmax_t itemcount;
+	FileBuffer fbuf;
 	uint8_t* filebuffer;
 	uintptr_t ptrData;
 	uintmax_t dataSize;
@@ -1051,6 +1299,9 @@ private:
 
 	uint32_t nulldata;
 
+	std::vector<StringEntry> index16;  // Side index for reading the strings as UTF-16, empty until first used
+	std::vector<StringEntry> index8;   // Same for 8-bit strings
+
 	uintptr_t GetStrPtr(int index)
 	{
 		if (index >= itemcount)
@@ -1065,6 +1316,42 @@ private:
 		return result;
 	}
 
+	// Item for a string at offset in the data block, which starts right after the item table
+	TxtItem MakeItem(uint32_t offset, uint32_t size)
+	{
+		uintmax_t fileOffset = tblSize + offset;
+		if (fileOffset > UINT32_MAX)
+			throw std::length_error("YgTextResource is too big, item offsets don't fit in 32 bits!");
+
+		return TxtItem{ static_cast<uint32_t>(fileOffset), size };
+	}
+
+	// End of an item's data, clamped to the end of the file
+	const uint8_t* GetItemEnd(int index)
+	{
+		const uint8_t* str = reinterpret_cast<const uint8_t*>(GetStrPtr(index));
+		const uint8_t* fileEnd = filebuffer + fileSize;
+		if (str == reinterpret_cast<const uint8_t*>(&nulldata))
+			return str;
+
+		return ((uintmax_t)(fileEnd - str) < items[index].size) ? fileEnd : (str + items[index].size);
+	}
+
+	template<typename CharT>
+	const std::vector<StringEntry>& buildIndex(std::vector<StringEntry>& index)
+	{
+		if (index.empty() && itemcount)
+		{
+			// items only share their string if both offset and size match
+			BuildStringIndex(itemcount,
+				[this](size_t i) { return ((uint64_t)items[i].size << 32) | items[i].offset; },
+				[this](size_t i) { return BoundedStrLength<CharT>(reinterpret_cast<const uint8_t*>(GetStrPtr((int)i)), GetItemEnd((int)i)); },
+				index);
+		}
+
+		return index;
+	}
+
 public:
 	wchar_t* c_wstr(int index)
 	{
@@ -1101,11 +1388,55 @@ public:
 		return items[index].size;
 	}
 
+	//
+	// Side index of the strings when read as UTF-16 / 8-bit, built on first use after a load or build.
+	// Entries whose first isn't their own index share the string of that earlier entry.
+	//
+	const std::vector<StringEntry>& stringIndex16()
+	{
+		return buildIndex<char16_t>(index16);
+	}
+
+	const std::vector<StringEntry>& stringIndex8()
+	{
+		return buildIndex<char8_t>(index8);
+	}
+
+	//
+	// Views of a string without copying it, bounded by the size of its item. Out of range indices give an empty view.
+	// They use the side index, which is built once per character width on first use after a load or build.
+	// viewRaw() is the whole item without the zeros padding it at the end.
+	//
+	std::u16string_view view16(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::u16string_view();
+		return std::u16string_view(c_u16str(index), buildIndex<char16_t>(index16)[index].length);
+	}
+
+	std::u8string_view view8(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::u8string_view();
+		return std::u8string_view(c_u8str(index), buildIndex<char8_t>(index8)[index].length);
+	}
+
+	std::string_view viewRaw(int index)
+	{
+		if ((index < 0) || (index >= count()))
+			return std::string_view();
+
+		const char* str = c_str(index);
+		const char* end = reinterpret_cast<const char*>(GetItemEnd(index));
+		while ((end > str) && (end[-1] == '\0'))
+			end--;
+
+		return std::string_view(str, end - str);
+	}
+
 	std::u16string u16string(int index)
 	{
-		if (index >= itemcount)
-			return std::u16string();
-		return std::u16string(c_u16str(index));
+		return std::u16string(view16(index));
 	}
 
 	std::wstring wstring(int index)
@@ -1117,16 +1448,13 @@ public:
 
 	std::u8string u8string(int index)
 	{
-		if (index >= itemcount)
-			return std::u8string();
-		return std::u8string(c_u8str(index));
+		return std::u8string(view8(index));
 	}
 
 	std::string string(int index)
 	{
-		if (index >= itemcount)
-			return std::string();
-		return std::string(c_str(index));
+		std::u8string_view str = view8(index);
+		return std::string(str.begin(), str.end());
 	}
 
 	int count()
@@ -1165,51 +1493,37 @@ public:
 	}
 
 	//
-	// Load a text resource from a file
+	// Load a text resource from a file (memory mapped where supported)
 	//
 	void openFile(std::filesystem::path filename)
 	{
-		std::ifstream ifile;
-		try
-		{
-			ifile.open(filename, std::ios::binary);
-			if (!ifile.is_open())
-			{
-				filebuffer = nullptr;
-				throw std::runtime_error(strerror(errno));
-			}
-		}
-		catch (const std::exception& e)
-		{
-			throw e;
-		}
+		Stats::Scope scope(Stats::STAGE_OPEN);
+		index16.clear();
+		index8.clear();
 
+		filebuffer = nullptr;
+		fbuf.openFile(filename);
 
-		uintmax_t filesize = 0;
-		try
-		{
-			filesize = std::filesystem::file_size(filename);
-		}
-		catch (const std::exception& e)
+		filebuffer = fbuf.data();
+		uintmax_t filesize = fbuf.size();
+
+		// the item table has to be in the file, the items are checked as they're read
+		items = (TxtItem*)filebuffer;
+		if ((filesize < sizeof(TxtItem)) || (items[0].offset > filesize))
 		{
-			ifile.close();
-			throw e;
+			items = nullptr;
+			itemcount = 0;
+			filebuffer = nullptr;
+			throw std::runtime_error("YgTextResource item table doesn't match the file size!");
 		}
 
-		if (filebuffer)
-			free(filebuffer);
-
-		filebuffer = (uint8_t*)malloc(filesize);
-		ifile.read((char*)filebuffer, filesize);
-		ifile.close();
-
-		items = (TxtItem*)filebuffer;
 		itemcount = items[0].offset / sizeof(TxtItem);
 
 		ptrData = reinterpret_cast<uintptr_t>(&filebuffer[items[0].offset]);
 		dataSize = filesize - items[0].offset;
 		tblSize = items[0].offset;
 		fileSize = filesize;
+		scope.addBytes(filesize);
 	}
 
 	//
@@ -1217,6 +1531,8 @@ public:
 	//
 	void exportFile(std::filesystem::path filename)
 	{
+		Stats::Scope scope(Stats::STAGE_WRITE);
+
 		if (filebuffer == nullptr)
 		{
 			throw std::runtime_error("YgTextResource filebuffer is null!");
@@ -1237,6 +1553,7 @@ public:
 		}
 
 		ofile.write((char*)filebuffer, fileSize);
+		scope.addBytes(fileSize);
 
 		ofile.flush();
 		ofile.close();
@@ -1244,29 +1561,49 @@ public:
 
 	//
 	// Builds a text resource out of a UTF-16 string vector
+	// Entries that aliases (from the txt parser) points elsewhere share that string without it being looked up again.
+	// Throws std::length_error if the result would be too big for the 32-bit item offsets.
 	//
-	void build(std::vector<std::u16string>* strings)
+	void build(std::vector<std::u16string>* strings, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (filebuffer)
-			free(filebuffer);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// generate the header
 		tblSize = strings->size() * sizeof(TxtItem);
 
 		StringBuffer stringBuffer;
+		stringBuffer.reserve(*strings, true);
 		std::vector<TxtItem> newitems;
+		newitems.reserve(strings->size());
 
-		for (const auto& str : *strings)
 		{
-			uint32_t currentOffset = stringBuffer.addStringAligned(str);
-			uint32_t size = stringBuffer.getAlignStrSize(str);
-			TxtItem ni = { currentOffset + tblSize , size };
-			newitems.push_back(ni);
+			Stats::Scope internScope(Stats::STAGE_INTERN);
+			for (size_t i = 0; i < strings->size(); i++)
+			{
+				// aliased items are filled in below
+				TxtItem ni = { 0, 0 };
+				if (!aliases || ((*aliases)[i] == i))
+				{
+					uint32_t size = 0;
+					uint32_t currentOffset = stringBuffer.addStringAligned((*strings)[i], size);
+					ni = MakeItem(currentOffset, size);
+				}
+				newitems.push_back(ni);
+			}
+
+			if (aliases)
+			{
+				for (size_t i = 0; i < newitems.size(); i++)
+					newitems[i] = newitems[(*aliases)[i]];
+			}
 		}
+		Stats::Add(Stats::COUNTER_STRINGS_UNIQUE, stringBuffer.uniqueCount());
 
 		// new buffer
 		uintmax_t newsize = tblSize + stringBuffer.dataSize();
-		filebuffer = (uint8_t*)malloc(newsize);
+		filebuffer = fbuf.allocate(newsize);
 
 		// copy data
 		uintmax_t cursor = 0;
@@ -1279,33 +1616,52 @@ public:
 		ptrData = reinterpret_cast<uintptr_t>(&filebuffer[items[0].offset]);
 		dataSize = newsize - items[0].offset;
 		fileSize = newsize;
+		scope.addBytes(newsize);
 	}
 
 	//
 	// Builds a text resource out of a UTF-8 string vector
 	//
-	void build(std::vector<std::u8string>* strings)
+	void build(std::vector<std::u8string>* strings, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (filebuffer)
-			free(filebuffer);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// generate the header
 		tblSize = strings->size() * sizeof(TxtItem);
 
 		StringBuffer stringBuffer;
+		stringBuffer.reserve(*strings, true);
 		std::vector<TxtItem> newitems;
+		newitems.reserve(strings->size());
 
-		for (const auto& str : *strings)
 		{
-			uint32_t currentOffset = stringBuffer.addStringAligned(str);
-			uint32_t size = stringBuffer.getAlignStrSize(str);
-			TxtItem ni = { currentOffset + tblSize , size };
-			newitems.push_back(ni);
+			Stats::Scope internScope(Stats::STAGE_INTERN);
+			for (size_t i = 0; i < strings->size(); i++)
+			{
+				// aliased items are filled in below
+				TxtItem ni = { 0, 0 };
+				if (!aliases || ((*aliases)[i] == i))
+				{
+					uint32_t size = 0;
+					uint32_t currentOffset = stringBuffer.addStringAligned((*strings)[i], size);
+					ni = MakeItem(currentOffset, size);
+				}
+				newitems.push_back(ni);
+			}
+
+			if (aliases)
+			{
+				for (size_t i = 0; i < newitems.size(); i++)
+					newitems[i] = newitems[(*aliases)[i]];
+			}
 		}
+		Stats::Add(Stats::COUNTER_STRINGS_UNIQUE, stringBuffer.uniqueCount());
 
 		// new buffer
 		uintmax_t newsize = tblSize + stringBuffer.dataSize();
-		filebuffer = (uint8_t*)malloc(newsize);
+		filebuffer = fbuf.allocate(newsize);
 
 		// copy data
 		uintmax_t cursor = 0;
@@ -1318,33 +1674,52 @@ public:
 		ptrData = reinterpret_cast<uintptr_t>(&filebuffer[items[0].offset]);
 		dataSize = newsize - items[0].offset;
 		fileSize = newsize;
+		scope.addBytes(newsize);
 	}
 
 	//
 	// Builds a text resource out of a raw string vector
 	//
-	void build(std::vector<std::string>* strings)
+	void build(std::vector<std::string>* strings, const std::vector<uint32_t>* aliases = nullptr)
 	{
-		if (filebuffer)
-			free(filebuffer);
+		Stats::Scope scope(Stats::STAGE_BUILD);
+		index16.clear();
+		index8.clear();
 
 		// generate the header
 		tblSize = strings->size() * sizeof(TxtItem);
 
 		StringBuffer stringBuffer;
+		stringBuffer.reserve(*strings, true);
 		std::vector<TxtItem> newitems;
+		newitems.reserve(strings->size());
 
-		for (const auto& str : *strings)
 		{
-			uint32_t currentOffset = stringBuffer.addStringRawAligned(str);
-			uint32_t size = stringBuffer.getAlignStrSize(str);
-			TxtItem ni = { currentOffset + tblSize , size };
-			newitems.push_back(ni);
+			Stats::Scope internScope(Stats::STAGE_INTERN);
+			for (size_t i = 0; i < strings->size(); i++)
+			{
+				// aliased items are filled in below
+				TxtItem ni = { 0, 0 };
+				if (!aliases || ((*aliases)[i] == i))
+				{
+					uint32_t size = 0;
+					uint32_t currentOffset = stringBuffer.addStringRawAligned((*strings)[i], size);
+					ni = MakeItem(currentOffset, size);
+				}
+				newitems.push_back(ni);
+			}
+
+			if (aliases)
+			{
+				for (size_t i = 0; i < newitems.size(); i++)
+					newitems[i] = newitems[(*aliases)[i]];
+			}
 		}
+		Stats::Add(Stats::COUNTER_STRINGS_UNIQUE, stringBuffer.uniqueCount());
 
 		// new buffer
 		uintmax_t newsize = tblSize + stringBuffer.dataSize();
-		filebuffer = (uint8_t*)malloc(newsize);
+		filebuffer = fbuf.allocate(newsize);
 
 		// copy data
 		uintmax_t cursor = 0;
@@ -1357,6 +1732,7 @@ public:
 		ptrData = reinterpret_cast<uintptr_t>(&filebuffer[items[0].offset]);
 		dataSize = newsize - items[0].offset;
 		fileSize = newsize;
+		scope.addBytes(newsize);
 	}
 
 	YgTextResource()
@@ -1371,11 +1747,6 @@ public:
 		tblSize = 0;
 	}
 
-	~YgTextResource()
-	{
-		if (filebuffer)
-			free(filebuffer);
-	}
 };
 
 #endif
\ No newline at end of file
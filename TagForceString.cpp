@@ -4,205 +4,73 @@
 //
 
 #include <iostream>
+#include <chrono>
 #include "TagForceString.hpp"
-#include "StrResource.hpp"
-#include "StoryScript.hpp"
-#include "TxtResource.hpp"
-#include "TF1Folder.hpp"
+#include "TagForceStringCli.hpp"
+#include "TagForceStringJobs.hpp"
 
 int main(int argc, char* argv[])
 {
-    std::cout << "Yu-Gi-Oh! Tag Force Language & String Tool\n\n";
-    if (argc < 4) 
+    if (argc < 2)
     {
-        //std::cerr << "Insufficient arguments.\n";
+        std::cout << "Yu-Gi-Oh! Tag Force Language & String Tool\n\n";
         TagForceString::printUsage(argv[0]);
         return 1;
     }
 
+    // in serve mode stdout carries the results, so keep it clean
     TagForceString::Options options = TagForceString::parseCommandLine(argc, argv);
-    TagForceString::UnicodeBOMType curBOM = TagForceString::UnicodeBOMType::BOM_UNKNOWN;
-
-    if (options.useUTF8)
-        std::cout << "UTF-8 mode enabled!\n";
+    bool bServe = (options.mode == TagForceString::SERVE);
+    bool bBatch = (options.mode == TagForceString::BATCH);
 
-    if (((options.mode == TagForceString::OperatingMode::TXT2BIN) || (options.mode == TagForceString::OperatingMode::TXT2LANG))
-        && (options.useBOM && !options.useUTF8))
+    (bServe ? std::cerr : std::cout) << "Yu-Gi-Oh! Tag Force Language & String Tool\n\n";
+    if ((argc < 4) && !bServe && !bBatch)
     {
-        try
-        {
-            curBOM = TagForceString::GetBOM(options.inputFilePath1);
-        }
-        catch (const std::exception& e)
-        {
-            std::cerr << "ERROR: Failed to open file: " << options.inputFilePath1.string() << " for reading.\n";
-            std::cerr << "Reason: " << e.what() << '\n';
-            return -1;
-        }
-
-        std::cout << "BOM: ";
-        switch (curBOM)
-        {
-            case TagForceString::UnicodeBOMType::BOM_UTF8:
-            {
-                std::cout << "UTF-8";
-                options.useUTF8 = true;
-                break;
-            }
-        
-            case TagForceString::UnicodeBOMType::BOM_UTF16LE:
-            {
-                std::cout << "UTF-16 Little Endian";
-                break;
-            }
-        
-            case TagForceString::UnicodeBOMType::BOM_UTF16BE:
-            {
-                std::cout << "UTF-16 Big Endian";
-                break;
-            }
-        
-            default:
-            {
-                std::cout << "Unknown";
-                break;
-            }
-        }
-        
-        std::cout << '\n';
-
-        if (curBOM == TagForceString::UnicodeBOMType::BOM_UTF16BE)
-        {
-            std::cerr << "Big endian BOM detected! Please only use little endian files!\n";
-            return 2;
-        }
+        //std::cerr << "Insufficient arguments.\n";
+        TagForceString::printUsage(argv[0]);
+        return 1;
     }
 
-    switch (options.mode)
-    {
-        case TagForceString::OperatingMode::BIN2TXT:
-        {
-            std::cout << "Converting: " << '\n' 
-                << " <- " << options.inputFilePath1.string() << '\n'
-                << " -> " << options.outputFilePath1.string() << '\n';
-            if (options.useRAW)
-                return StrResource::ExportRaw(options.inputFilePath1, options.outputFilePath1);
-            if (options.useUTF8)
-                return StrResource::ExportU8(options.inputFilePath1, options.outputFilePath1, options.useBOM);
-            else
-                return StrResource::ExportU16(options.inputFilePath1, options.outputFilePath1, options.useBOM);
-
-            break;
-        }
+    bool bStats = options.stats || !options.statsJsonPath.empty();
+    Stats::Enable(bStats);
+    Stats::EnableTrace(!options.tracePath.empty());
 
-        case TagForceString::OperatingMode::TXT2BIN:
-        {
-            std::cout << "Converting: " << '\n'
-                << " <- " << options.inputFilePath1.string() << '\n'
-                << " -> " << options.outputFilePath1.string() << '\n';
-            if (options.useRAW)
-                return StrResource::ImportRaw(options.inputFilePath1, options.outputFilePath1);
-            if (options.useUTF8)
-                return StrResource::ImportU8(options.inputFilePath1, options.outputFilePath1);
-            else
-                return StrResource::ImportU16(options.inputFilePath1, options.outputFilePath1);
+    auto startTime = std::chrono::steady_clock::now();
 
-            break;
-        }
+    int result = 0;
+    if (options.mode == TagForceString::SERVE)
+        result = TagForceString::Serve(options.jobs, options.socketPath);
+    else if (options.mode == TagForceString::BATCH)
+        result = TagForceString::RunBatch(options.inputFilePath1, options.jobs);
+    else
+        result = TagForceString::RunOptions(options);
 
-        case TagForceString::OperatingMode::TBIN2TXT:
-        {
-            std::cout << "Converting: " << '\n'
-                << " <- " << options.inputFilePath1.string() << '\n'
-                << " -> " << options.outputFilePath1.string() << '\n';
-            if (options.useRAW)
-                return TxtResource::ExportRaw(options.inputFilePath1, options.outputFilePath1);
-            if (options.useUTF8)
-                return TxtResource::ExportU8(options.inputFilePath1, options.outputFilePath1, options.useBOM);
-            else
-                return TxtResource::ExportU16(options.inputFilePath1, options.outputFilePath1, options.useBOM);
-
-            break;
-        }
-
-        case TagForceString::OperatingMode::TXT2TBIN:
-        {
-            std::cout << "Converting: " << '\n'
-                << " <- " << options.inputFilePath1.string() << '\n'
-                << " -> " << options.outputFilePath1.string() << '\n';
-            if (options.useRAW)
-                return TxtResource::ImportRaw(options.inputFilePath1, options.outputFilePath1);
-            if (options.useUTF8)
-                return TxtResource::ImportU8(options.inputFilePath1, options.outputFilePath1);
-            else
-                return TxtResource::ImportU16(options.inputFilePath1, options.outputFilePath1);
-
-            break;
-        }
-
-        case TagForceString::OperatingMode::LANG2TXT:
-        {
-            std::cout << "Converting: " << '\n'
-                << " <- " << options.inputFilePath1.string() << '\n'
-                << " <- " << options.inputFilePath2.string() << '\n'
-                << " -> " << options.outputFilePath1.string() << '\n';
-            if (options.useRAW)
-                return StoryScript::ExportRaw(options.inputFilePath1, options.inputFilePath2, options.outputFilePath1);
-            if (options.useUTF8)
-                return StoryScript::ExportU8(options.inputFilePath1, options.inputFilePath2, options.outputFilePath1, options.useBOM);
-            else
-                return StoryScript::ExportU16(options.inputFilePath1, options.inputFilePath2, options.outputFilePath1, options.useBOM);
-
-            break;
-        }
-
-        case TagForceString::OperatingMode::TXT2LANG:
-        {
-            std::cout << "Converting: " << '\n'
-                << " <- " << options.inputFilePath1.string() << '\n'
-                << " -> " << options.outputFilePath1.string() << '\n'
-                << " -> " << options.outputFilePath2.string() << '\n';
-            if (options.useRAW)
-                return StoryScript::ImportRaw(options.inputFilePath1, options.outputFilePath1, options.outputFilePath2);
-            if (options.useUTF8)
-                return StoryScript::ImportU8(options.inputFilePath1, options.outputFilePath1, options.outputFilePath2);
-            else
-                return StoryScript::ImportU16(options.inputFilePath1, options.outputFilePath1, options.outputFilePath2);
+    if (bStats)
+    {
+        double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        Stats::Totals totals = Stats::Collect();
 
-            break;
-        }
+        if (options.stats)
+            TagForceString::PrintStats(totals, wallMs, bServe ? std::cerr : std::cout);
 
-        case TagForceString::OperatingMode::FOLD2TXT:
+        if (!options.statsJsonPath.empty() && !TagForceString::WriteStatsJson(options, totals, wallMs))
         {
-            std::cout << "Converting: " << '\n'
-                << " <- " << options.inputFilePath1.string() << '\n'
-                << " -> " << options.outputFilePath1.string() << '\n';
-            if (options.useRAW)
-                return TF1Folder::ExportFolderRaw(options.inputFilePath1, options.outputFilePath1);
-            if (options.useUTF8)
-                return TF1Folder::ExportFolderU8(options.inputFilePath1, options.outputFilePath1);
-            else
-                return TF1Folder::ExportFolderU16(options.inputFilePath1, options.outputFilePath1);
-
-            break;
+            std::cerr << "ERROR: Failed to write stats to: " << options.statsJsonPath.string() << '\n';
+            if (result == 0)
+                result = 1;
         }
+    }
 
-        case TagForceString::OperatingMode::TXT2FOLD:
+    if (!options.tracePath.empty())
+    {
+        Stats::EnableTrace(false);
+        if (!TagForceString::WriteTraceJson(options, Stats::CollectTrace()))
         {
-            std::cout << "Converting: " << '\n'
-                << " <- " << options.inputFilePath1.string() << '\n'
-                << " -> " << options.outputFilePath1.string() << '\n';
-
-            if (options.useRAW)
-                return TF1Folder::ImportFolderRaw(options.inputFilePath1, options.outputFilePath1);
-            if (options.useUTF8)
-                return TF1Folder::ImportFolderU8(options.inputFilePath1, options.outputFilePath1);
-            else
-                return TF1Folder::ImportFolderU16(options.inputFilePath1, options.outputFilePath1);
-
-            break;
+            std::cerr << "ERROR: Failed to write trace to: " << options.tracePath.string() << '\n';
+            if (result == 0)
+                result = 1;
         }
     }
 
-    return 0;
+    return result;
 }
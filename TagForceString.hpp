@@ -7,160 +7,150 @@
 #include <unordered_map>
 #include <vector>
 #include <functional>
+#include <sstream>
+#include <mutex>
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include "FileBuffer.hpp"
+#include "SimdScan.hpp"
 
 #ifndef TFSTRING_HDR
 #define TFSTRING_HDR
 
 namespace TagForceString
 {
-	enum OperatingMode
+	enum TextEncoding
 	{
-		BIN2TXT,
-		TXT2BIN,
-		TBIN2TXT,
-		TXT2TBIN,
-		LANG2TXT,
-		TXT2LANG,
-		FOLD2TXT,
-		TXT2FOLD
+		ENC_UTF16,
+		ENC_UTF8,
+		ENC_RAW
 	};
 
-	struct Options
-	{
-		OperatingMode mode = BIN2TXT;
-		std::filesystem::path inputFilePath1;
-		std::filesystem::path inputFilePath2;
-		std::filesystem::path outputFilePath1;
-		std::filesystem::path outputFilePath2;
-		bool useUTF8 = false;       // Default is UTF-16
-		bool useBOM = true;
-		bool useRAW = false;
-	};
+	//
+	// Console sinks used by the converters instead of std::cout / std::cerr.
+	// They can be pointed elsewhere per thread, so jobs running in parallel can collect their own output.
+	//
+	std::ostream& ConOut();
+
+	std::ostream& ConErr();
 
-	void printUsage(const char* programName)
+	//
+	// Point the current thread's sinks somewhere else. Return the previous sink.
+	//
+	std::ostream* SetConOut(std::ostream* out);
+
+	std::ostream* SetConErr(std::ostream* err);
+
+	//
+	// Buffers the console output of the current thread until it's flushed as one block
+	//
+	class BufferedConsole
 	{
-		std::cerr << "Usage: " << programName << " [OPTIONS] MODE INPUT OUTPUT\n"
-			<< "\nOPTIONS:\n"
-			<< "  -u, --utf8          Use UTF-8 / 8-bit encoding (default is UTF-16)\n"
-			<< "  -d, --no-bom        Disable BOM autodetection for input text files and BOM writing for output\n"
-			<< "  -r, --raw           Treat string data as raw data. Useful for Shift-JIS.\n"
-			<< "\nSTRING RESOURCE MODES:\n"
-			<< "  bin2txt           Convert a string resource (strtbl) file to a text file\n"
-			<< "  txt2bin           Convert a text file to a string resource (strtbl) file\n"
-			<< "\nTEXT RESOURCE MODES:\n"
-			<< "  tbin2txt          Convert a text resource (e.g. tutorial) file to a text file\n"
-			<< "  txt2tbin          Convert a text file to a text resource (e.g. tutorial) file\n"
-			<< "\nLANG FILE MODES:\n"
-			<< "  lang2txt          Convert a pair of lang files (index and strings) to a text file\n"
-			<< "  txt2lang          Convert a text file to a pair of lang files (index and strings)\n"
-			<< "\nFOLDER MODES:\n"
-			<< "  fold2txt          Batch convert a folder with lang file pairs to a folder with text files\n"
-			<< "  txt2fold          Batch convert a folder with text files to a folder with lang file pairs\n"
-			<< "\nEXAMPLES:\n"
-			<< "  " << programName << " bin2txt input_e.bin output.txt\n"
-			<< "  " << programName << " txt2bin input.txt output_e.bin\n"
-			<< "  " << programName << " lang2txt langIe.bin langLe.bin output.txt\n"
-			<< "  " << programName << " --utf8 txt2lang input.txt outIe.bin outLe.bin\n"
-			<< "  " << programName << " fold2txt in_folder out_folder\n"
-			<< "  " << programName << " txt2fold in_folder out_folder\n"
-			<< "\nNOTES:\n"
-			<< " - Folder modes MUST follow the correct filename format! (e.g. langIe.bin & langLe.bin & lang_e.txt)\n"
-			<< " - The encoding must match on both input and output files! The tool does not perform any conversion!\n"
-			<< "For more information, please read the README."
-			<< '\n';
-	}
+	private:
+		std::ostringstream bufOut;
+		std::ostringstream bufErr;
+		std::ostream* pOldOut;
+		std::ostream* pOldErr;
+
+		static std::mutex& flushMutex()
+		{
+			static std::mutex mtx;
+			return mtx;
+		}
+
+	public:
+		BufferedConsole()
+		{
+			pOldOut = SetConOut(&bufOut);
+			pOldErr = SetConErr(&bufErr);
+		}
+
+		//
+		// Takes the collected output away without printing it
+		//
+		std::string takeOut()
+		{
+			std::string str = bufOut.str();
+			bufOut.str(std::string());
+			return str;
+		}
+
+		std::string takeErr()
+		{
+			std::string str = bufErr.str();
+			bufErr.str(std::string());
+			return str;
+		}
+
+		//
+		// Writes everything collected so far to the previous sinks, without interleaving with other threads
+		//
+		void flush()
+		{
+			std::string strOut = takeOut();
+			std::string strErr = takeErr();
+			if (strOut.empty() && strErr.empty())
+				return;
+
+			std::lock_guard<std::mutex> lock(flushMutex());
+			pOldOut->write(strOut.data(), strOut.size());
+			pOldOut->flush();
+			pOldErr->write(strErr.data(), strErr.size());
+			pOldErr->flush();
+		}
+
+		~BufferedConsole()
+		{
+			flush();
+			SetConOut(pOldOut);
+			SetConErr(pOldErr);
+		}
+	};
 
-	Options parseCommandLine(int argc, char* argv[])
+	//
+	// Prints the output of numbered jobs strictly in job order.
+	// A job's output is held back until every job before it has reported.
+	//
+	class OrderedReporter
 	{
-		Options options;
+	private:
+		std::mutex mtx;
+		std::vector<std::string> outs;
+		std::vector<std::string> errs;
+		std::vector<bool> done;
+		size_t next;
+		std::ostream* pOut;
+		std::ostream* pErr;
+
+	public:
+		// output goes to the sinks of the thread that creates the reporter
+		explicit OrderedReporter(size_t jobCount) : outs(jobCount), errs(jobCount), done(jobCount, false), next(0)
+		{
+			pOut = &ConOut();
+			pErr = &ConErr();
+		}
 
-		for (int i = 1; i < argc; ++i)
+		void report(size_t index, std::string strOut, std::string strErr)
 		{
-			std::string arg = argv[i];
+			std::lock_guard<std::mutex> lock(mtx);
+			outs[index] = std::move(strOut);
+			errs[index] = std::move(strErr);
+			done[index] = true;
 
-			if (arg == "-u" || arg == "--utf8")
+			while ((next < done.size()) && done[next])
 			{
-				options.useUTF8 = true;
-			}
-			else if (arg == "-d" || arg == "--no-bom")
-			{
-				options.useBOM = false;
-			}
-			else if (arg == "-r" || arg == "--raw")
-			{
-				options.useRAW = true;
-			}
-			else if (arg == "bin2txt")
-			{
-				options.mode = BIN2TXT;
-			}
-			else if (arg == "txt2bin")
-			{
-				options.mode = TXT2BIN;
-			}
-			else if (arg == "tbin2txt")
-			{
-				options.mode = TBIN2TXT;
-			}
-			else if (arg == "txt2tbin")
-			{
-				options.mode = TXT2TBIN;
-			}
-			else if (arg == "fold2txt")
-			{
-				options.mode = FOLD2TXT;
-			}
-			else if (arg == "txt2fold")
-			{
-				options.mode = TXT2FOLD;
-			}
-			else if (arg == "lang2txt")
-			{
-				options.mode = LANG2TXT;
-				if (i + 3 < argc)
-				{
-					options.inputFilePath1 = argv[++i];
-					options.inputFilePath2 = argv[++i];
-					options.outputFilePath1 = argv[++i];
-				}
-				else
-				{
-					std::cerr << "Insufficient arguments for lang2txt. Use '" << argv[0] << "' for help.\n";
-					//printUsage(argv[0]);
-					exit(1);
-				}
-			}
-			else if (arg == "txt2lang")
-			{
-				options.mode = TXT2LANG;
-				if (i + 3 < argc)
-				{
-					options.inputFilePath1 = argv[++i];
-					options.outputFilePath1 = argv[++i];
-					options.outputFilePath2 = argv[++i];
-				}
-				else
-				{
-					std::cerr << "Insufficient arguments for txt2lang. Use '" << argv[0] << "' for help.\n";
-					//printUsage(argv[0]);
-					exit(1);
-				}
-			}
-			else if (i + 2 <= argc)
-			{
-				options.inputFilePath1 = argv[i++];
-				options.outputFilePath1 = argv[i++];
-			}
-			else
-			{
-				std::cerr << "Invalid arguments. Use '" << argv[0] << "' for help.\n";
-				//printUsage(argv[0]);
-				exit(1);
+				*pOut << outs[next];
+				pOut->flush();
+				*pErr << errs[next];
+				pErr->flush();
+
+				outs[next].clear();
+				errs[next].clear();
+				next++;
 			}
 		}
-
-		return options;
-	}
+	};
 
 	enum UnicodeBOMType
 	{
@@ -171,601 +161,401 @@ namespace TagForceString
 		BOM_COUNT
 	};
 
-	UnicodeBOMType GetBOM(std::ifstream& file)
-	{
-		std::streampos oldpos = file.tellg();
-
-		uint8_t bomchk1 = file.get();
-		uint8_t bomchk2 = file.get();
-		uint8_t bomchk3 = file.get();
-
-		file.seekg(oldpos, std::ios::beg);
+	UnicodeBOMType GetBOM(std::ifstream& file);
 
-		if ((bomchk1 == 0xEF) && (bomchk2 == 0xBB) && (bomchk3 == 0xBF))
-			return UnicodeBOMType::BOM_UTF8;
+	UnicodeBOMType GetBOM(std::filesystem::path filename);
 
-		uint16_t bomchk = (uint16_t)(bomchk2 << 8) | bomchk1;
-		if (bomchk == 0xFFFE)
-			return UnicodeBOMType::BOM_UTF16BE;
-
-		if (bomchk == 0xFEFF)
-			return UnicodeBOMType::BOM_UTF16LE;
-
-		return UnicodeBOMType::BOM_UNKNOWN;
-	}
+	//
+	// Gets the BOM of a text that is already in memory
+	//
+	UnicodeBOMType GetBOM(const uint8_t* data, uintmax_t size);
 
-	UnicodeBOMType GetBOM(std::filesystem::path filename)
+	template<typename CharT>
+	bool isTrimSpace(CharT ch)
 	{
-		std::ifstream file;
-		try
-		{
-			file.open(filename, std::ios::binary);
-			if (!file.is_open())
-			{
-				throw std::runtime_error(strerror(errno));
-			}
-		}
-		catch (const std::exception& e)
-		{
-			throw e;
-		}
-
-		UnicodeBOMType result = GetBOM(file);
-
-		file.close();
-
-		return result;
+		return (ch == ' ') || ((ch >= '\t') && (ch <= '\r'));
 	}
 
-	std::u16string readlineu16(std::ifstream& file)
+	//
+	// Reads a line from a text in memory and moves the cursor past it.
+	// UTF-16 lines also end at a NUL or a broken surrogate pair, 8-bit lines skip NULs.
+	//
+	template<typename CharT>
+	void readline(const CharT*& cursor, const CharT* end, std::basic_string<CharT>& line)
 	{
-		std::u16string line;
-		char16_t ch;
+		const CharT* stop = cursor;
+		ptrdiff_t skip = 0;
 
-		// Read until newline character or end of file
-		file.read((char*)&ch, sizeof(char16_t));
-		while (ch && ch != L'\n')
+		if constexpr (sizeof(CharT) == sizeof(char16_t))
 		{
-			// Check for surrogate pair
-			if (ch >= 0xD800 && ch <= 0xDBFF)
+			while (stop < end)
 			{
-				// This is the first code unit of a surrogate pair
-				char16_t secondUnit;
-				file.read((char*)&secondUnit, sizeof(char16_t));
-				if (secondUnit && secondUnit >= 0xDC00 && secondUnit <= 0xDFFF)
+				CharT ch = *stop;
+				if ((ch == '\n') || (ch == 0))
 				{
-					// Valid surrogate pair
-					line.push_back(ch);
-					line.push_back(secondUnit);
+					skip = 1;
+					break;
 				}
-				else
+
+				// Check for surrogate pair
+				if ((ch >= 0xD800) && (ch <= 0xDBFF))
 				{
-					// Invalid surrogate pair, handle error or break the loop
+					if (((stop + 1) < end) && (stop[1] >= 0xDC00) && (stop[1] <= 0xDFFF))
+					{
+						stop += 2;
+						continue;
+					}
+
+					// Invalid surrogate pair, both units are dropped and the line ends here
+					skip = 2;
 					break;
 				}
-			}
-			else
-			{
-				// Single code unit character
-				line.push_back(ch);
+
+				stop++;
 			}
 
-			file.read((char*)&ch, sizeof(char16_t));
+			line.assign(cursor, stop);
 		}
-
-		return line;
-	}
-
-	std::u8string readlineu8(std::ifstream& file)
-	{
-		std::u8string utf8Line;
-		char buffer[4];  // UTF-8 characters can be up to 4 bytes
-		char c;
-		while (file.get(c) && c != '\n')
+		else
 		{
-			if ((c & 0xC0) != 0x80)
-			{
-				// Check if it is the start of a UTF-8 character
-				int bytesRead = 0;
-				while ((c & 0xC0) == 0x80)
-				{
-					buffer[bytesRead++] = c;
-					file.get(c);
-				}
-
-				// Add the start byte
-				buffer[bytesRead++] = c;
-				buffer[bytesRead] = '\0';
+			stop = SimdScan::findAny(cursor, end, '\n');
+			if (stop < end)
+				skip = 1;
 
-				// Convert the buffer to a UTF-8 character and append to the u8string
-				utf8Line += reinterpret_cast<const char8_t*>(buffer);
-			}
-			else
-			{
-				// Handle single-byte character
-				utf8Line += static_cast<char8_t>(c);
-			}
+			line.assign(cursor, stop);
+			if (memchr(line.data(), 0, line.size()))
+				line.erase(std::remove(line.begin(), line.end(), 0), line.end());
 		}
 
-		return utf8Line;
+		cursor = stop + std::min(skip, end - stop);
 	}
 
-	std::string readline(std::ifstream& file)
-	{
-		std::string line;
-		char buffer[4];  // UTF-8 characters can be up to 4 bytes
-		char c;
-		while (file.get(c) && c != '\n')
-		{
-			if ((c & 0xC0) != 0x80)
-			{
-				// Check if it is the start of a UTF-8 character
-				int bytesRead = 0;
-				while ((c & 0xC0) == 0x80)
-				{
-					buffer[bytesRead++] = c;
-					file.get(c);
-				}
+	void removeCRLF(std::u16string& str);
 
-				// Add the start byte
-				buffer[bytesRead++] = c;
-				buffer[bytesRead] = '\0';
+	void removeCRLF(std::u8string& str);
 
-				// Convert the buffer to a UTF-8 character and append to the u8string
-				line += reinterpret_cast<const char*>(buffer);
-			}
-			else
-			{
-				// Handle single-byte character
-				line += static_cast<char>(c);
-			}
-		}
+	void removeCRLF(std::string& str);
 
-		return line;
-	}
+	bool isStrNumeric(const std::string& str);
 
-	void removeCRLF(std::u16string& str)
+	//
+	// Length of a string once every '\\' and '[' in it is escaped
+	//
+	template<typename CharT>
+	size_t escapedLength(const CharT* str, size_t len)
 	{
-		if (!str.empty())
-		{
-			if (str.back() == u'\n')
-			{
-				str.pop_back();
-			}
+		const CharT* end = str + len;
+		size_t outLen = len;
 
-			if (!str.empty() && str.back() == u'\r')
-			{
-				str.pop_back();
-			}
-		}
-	}
-
-	void removeCRLF(std::u8string& str)
-	{
-		if (!str.empty())
-		{
-			if (str.back() == u8'\n')
-			{
-				str.pop_back();
-			}
+		for (const CharT* p = SimdScan::findAny(str, end, '\\', '['); p < end; p = SimdScan::findAny(p + 1, end, '\\', '['))
+			outLen++;
 
-			if (!str.empty() && str.back() == u8'\r')
-			{
-				str.pop_back();
-			}
-		}
+		return outLen;
 	}
 
-	void removeCRLF(std::string& str)
+	//
+	// Escapes '\\' and '[' in a single pass, copying the runs in between as they are.
+	// out needs room for escapedLength() units. Returns the end of the written data.
+	//
+	template<typename CharT>
+	CharT* escapeInto(const CharT* str, size_t len, CharT* out)
 	{
-		if (!str.empty())
+		const CharT* end = str + len;
+
+		while (str < end)
 		{
-			if (str.back() == '\n')
-			{
-				str.pop_back();
-			}
+			const CharT* special = SimdScan::findAny(str, end, '\\', '[');
+			memcpy(out, str, (special - str) * sizeof(CharT));
+			out += special - str;
+			str = special;
 
-			if (!str.empty() && str.back() == '\r')
-			{
-				str.pop_back();
-			}
+			if (str == end)
+				break;
+
+			*out++ = '\\';
+			*out++ = *str++;
 		}
+
+		return out;
 	}
 
-	bool isStrNumeric(const std::string& str) 
+	//
+	// Reads a section index, warns and returns false if it isn't a plain number
+	//
+	inline bool parseSectionIndex(const std::string& idStr, int& id)
 	{
-		for (char ch : str)
+		const char* idEnd = idStr.data() + idStr.size();
+		std::from_chars_result res = std::from_chars(idStr.data(), idEnd, id);
+		if (idStr.empty() || !isStrNumeric(idStr) || (res.ec != std::errc()) || (res.ptr != idEnd))
 		{
-			if (ch >= -1 && ch <= 255)
-			{
-				if (!std::isdigit(ch))
-				{
-					return false;
-				}
-			}
-			else
-				return false;
+			ConOut() << "WARNING: Section " << idStr << " ignored!\n";
+			return false;
 		}
+
 		return true;
 	}
 
-	std::string escapeCharacter(const std::string& input, char characterToEscape) 
+	//
+	// Checks if a line is a section header ("[N]", trailing whitespace allowed) and gets its index.
+	// An alias header ("[N]=@M") also gets the index of the section whose string it shares, otherwise aliasOf is -1.
+	//
+	template<typename CharT>
+	bool parseSectionHeader(std::basic_string<CharT>& line, int& id, int& aliasOf)
 	{
-		std::string result;
-
-		for (char c : input) {
-			if (c == characterToEscape) {
-				result += '\\';
-			}
-			result += c;
-		}
+		while (!line.empty() && isTrimSpace(line.back()))
+			line.pop_back();
 
-		return result;
-	}
+		aliasOf = -1;
+		if (line.empty() || (line.front() != '['))
+			return false;
 
-	std::u16string escapeCharacter(const std::u16string& input, char16_t characterToEscape)
-	{
-		std::u16string result;
+		size_t close = line.size() - 1;
+		if (line.back() != ']')
+		{
+			close = line.find(static_cast<CharT>(']'));
+			if ((close == std::basic_string<CharT>::npos) || ((close + 2) >= line.size()) || (line[close + 1] != '=') || (line[close + 2] != '@'))
+				return false;
 
-		for (char16_t c : input) {
-			if (c == characterToEscape) {
-				result += '\\';
-			}
-			result += c;
+			if (!parseSectionIndex(std::string(line.begin() + close + 3, line.end()), aliasOf))
+				return false;
 		}
 
-		return result;
+		return parseSectionIndex(std::string(line.begin() + 1, line.begin() + close), id);
 	}
 
-	std::u8string escapeCharacter(const std::u8string& input, char8_t characterToEscape)
+	//
+	// Reads section data up to the next unescaped '[', which is left for the next header.
+	// The runs between escapes are found with SIMD and copied in one go.
+	//
+	template<typename CharT>
+	void readSectionData(const CharT*& cursor, const CharT* end, std::basic_string<CharT>& data, int linecounter)
 	{
-		std::u8string result;
+		while (cursor < end)
+		{
+			const CharT* run = cursor;
+			cursor = SimdScan::findAny(cursor, end, '\\', '[');
 
-		for (char8_t c : input) {
-			if (c == characterToEscape) {
-				result += '\\';
+			data.append(run, cursor - run);
+
+			if ((cursor == end) || (*cursor == '['))
+				break;
+
+			// escape
+			CharT ch = *cursor++;
+			CharT nxch = (cursor < end) ? *cursor : 0;
+			if ((nxch == '[') || (nxch == '\\'))
+			{
+				data.push_back(nxch);
+				cursor++;
+			}
+			else
+			{
+				data.push_back(ch);
+				ConOut() << "WARNING: Unknown escape character '" << (char)ch << (char)nxch << "' at string " << linecounter << '\n';
 			}
-			result += c;
 		}
-
-		return result;
 	}
 
 	//
-	// Parses an ini-like (UTF-16 LE BOM) formatted txt file and returns a vector to the given pointer.
+	// Reads raw section data. There are no escapes, so a '[' only ends the data if it starts a "[N]" header within 6 chars.
 	//
-	int ParseTxtU16(std::filesystem::path txtFilename, std::vector<std::u16string>* outStrings)
+	inline void readSectionDataRaw(const char*& cursor, const char* end, std::string& data)
 	{
-		std::ifstream txtfile;
-		try
-		{
-			txtfile.open(txtFilename, std::ios::binary);
-			if (!txtfile.is_open())
-			{
-				throw std::runtime_error(strerror(errno));
-			}
-		}
-		catch (const std::exception& e)
-		{
-			std::cerr << "ERROR: Failed to open file: " << txtFilename.string() << " for reading.\n";
-			std::cerr << "Reason: " << e.what() << '\n';
-			return -1;
-		}
-
-		// check BOM and skip if valid...
-		UnicodeBOMType bt = GetBOM(txtfile);
-		if (bt == UnicodeBOMType::BOM_UTF16BE)
+		while (cursor < end)
 		{
-			txtfile.close();
-			std::cerr << "Big endian BOM detected! Please only use little endian files!\n";
-			return -2;
-		}
-
-		if (bt == UnicodeBOMType::BOM_UTF16LE)
-			txtfile.seekg(2, std::ios::beg);
-		else
-			std::cout << "WARNING: Unknown or no BOM detected!\n";
-
-		// create a map of strings per index to keep them in order
-		std::map<int, std::u16string> strMap;
+			const char* run = cursor;
+			cursor = SimdScan::findAny(cursor, end, '[');
 
-		int linecounter = 0;
+			data.append(run, cursor - run);
 
-		while (!txtfile.eof())
-		{
-			std::u16string line = readlineu16(txtfile);
-			
-			// trim any newline chars
-			line.erase(std::find_if(line.rbegin(), line.rend(), std::not_fn(std::function<int(int)>(::isspace))).base(), line.end());
-			if (!(!line.empty() && line.front() == u'[' && line.back() == u']'))
-				continue;
+			if (cursor == end)
+				break;
 
-			std::u16string idStrU16 = line.substr(1, line.length() - 2);
-			std::string idStr(idStrU16.begin(), idStrU16.end());
-			if (!isStrNumeric(idStr))
+			// search for the ']' character within the next 6 chars
+			bool bFoundSectionEnd = false;
+			const char* search = cursor + 1;
+			for (int i = 0; (i < 6) && (search < end); i++, search++)
 			{
-				std::cout << "WARNING: Section " << idStr << " ignored!\n";
-				continue;
-			}
-			int id = std::stoi(idStr);
-			std::u16string data;
-			while (!txtfile.eof())
-			{
-				char16_t ch;
-				txtfile.read((char*)&ch, sizeof(char16_t));
-				if (ch == u'\\')
-				{
-					char16_t nxch = u'\0';
-					if (!txtfile.eof())
-						txtfile.read((char*)&nxch, sizeof(char16_t));
-					if (nxch == u'[')
-					{
-						data.push_back(nxch);
-						if (txtfile.eof())
-							break;
-					}
-					else if (nxch == u'\\')
-					{
-						data.push_back(nxch);
-						if (txtfile.eof())
-							break;
-					}
-					else
-					{
-						txtfile.seekg(-static_cast<std::streamoff>(sizeof(char16_t)), std::ios::cur);
-						data.push_back(ch);
-						std::cout << "WARNING: Unknown escape character '" << (char)ch << (char)nxch << "' at string " << linecounter << '\n';
-					}
-				}
-				else
+				if (*search == ']')
 				{
-					if (ch == u'[')
-					{
-						txtfile.seekg(-static_cast<std::streamoff>(sizeof(char16_t)), std::ios::cur);
-						break;
-					}
-					if (txtfile.eof())
-						break;
-					data.push_back(ch);
+					bFoundSectionEnd = isStrNumeric(std::string(cursor + 1, search));
+					break;
 				}
 			}
 
-			removeCRLF(data);
-			strMap[id] = data;
-			linecounter++;
-		}
+			if (bFoundSectionEnd)
+				break;
 
-		// copy strings in index order
-		for (const auto& pair : strMap)
-		{
-			outStrings->push_back(pair.second);
+			data.push_back(*cursor++);
 		}
-
-
-		return 0;
 	}
 
 	//
-	// Parses an ini-like (UTF-8) formatted txt file and returns a vector to the given pointer.
+	// A parsed section. An alias section has no text of its own, it shares the string of another section.
 	//
-	int ParseTxtU8(std::filesystem::path txtFilename, std::vector<std::u8string>* outStrings)
+	template<typename StringT>
+	struct TxtSection
 	{
-		std::ifstream txtfile;
-		try
-		{
-			txtfile.open(txtFilename, std::ios::binary);
-			if (!txtfile.is_open())
-			{
-				throw std::runtime_error(strerror(errno));
-			}
-		}
-		catch (const std::exception& e)
-		{
-			std::cerr << "ERROR: Failed to open file: " << txtFilename.string() << " for reading.\n";
-			std::cerr << "Reason: " << e.what() << '\n';
-			return -1;
-		}
-
-		// check BOM and skip if valid...
-		UnicodeBOMType bt = GetBOM(txtfile);
-		if ((bt == UnicodeBOMType::BOM_UTF16LE) || (bt == UnicodeBOMType::BOM_UTF16BE))
-		{
-			txtfile.close();
-			std::cerr << "UTF-16 BOM detected! Please check that you're using a UTF-8 file!\n";
-			return -2;
-		}
-		if (bt == UnicodeBOMType::BOM_UTF8)
-			txtfile.seekg(3, std::ios::beg);
-		else
-			std::cout << "WARNING: Unknown or no BOM detected!\n";
-
-		// create a map of strings per index to keep them in order
-		std::map<int, std::u8string> strMap;
+		int id;
+		int aliasOf;    // -1 for a section with its own text
+		StringT data;
+	};
 
+	//
+	// Splits a text in memory into its sections, in the order they appear.
+	// Everything outside of a section is skipped.
+	//
+	template<typename CharT, bool bRaw>
+	void parseSections(const CharT* cursor, const CharT* end, std::vector<TxtSection<std::basic_string<CharT>>>& sections)
+	{
+		std::basic_string<CharT> line;
+		std::basic_string<CharT> data;
 		int linecounter = 0;
 
-		while (!txtfile.eof())
+		while (cursor < end)
 		{
-			std::u8string line = readlineu8(txtfile);
-			
-			// trim any newline chars
-			line.erase(std::find_if(line.rbegin(), line.rend(), std::not_fn(std::function<int(int)>(::isspace))).base(), line.end());
-			if (!(!line.empty() && line.front() == u8'[' && line.back() == u8']'))
+			readline(cursor, end, line);
+
+			int id = 0;
+			int aliasOf = -1;
+			if (!parseSectionHeader(line, id, aliasOf))
 				continue;
 
-			std::u8string idStrU8 = line.substr(1, line.length() - 2);
-			std::string idStr(idStrU8.begin(), idStrU8.end());
-			if (!isStrNumeric(idStr))
+			// the scratch buffer is reused, so every stored string is allocated once at its final size
+			data.clear();
+			if constexpr (bRaw)
+				readSectionDataRaw(cursor, end, data);
+			else
+				readSectionData(cursor, end, data, linecounter);
+
+			removeCRLF(data);
+			if (aliasOf < 0)
 			{
-				std::cout << "WARNING: Section " << idStr << " ignored!\n";
-				continue;
+				sections.push_back({ id, -1, data });
 			}
-			int id = std::stoi(idStr);
-			std::u8string data;
-			while (!txtfile.eof())
+			else
 			{
-				char8_t ch;
-				txtfile.read((char*)&ch, sizeof(char8_t));
-				if (ch == u8'\\')
-				{
-					char8_t nxch = u8'\0';
-					if (!txtfile.eof())
-						txtfile.read((char*)&nxch, sizeof(char8_t));
-					if (nxch == u8'[')
-					{
-						data.push_back(nxch);
-						if (txtfile.eof())
-							break;
-					}
-					else if (nxch == u8'\\')
-					{
-						data.push_back(nxch);
-						if (txtfile.eof())
-							break;
-					}
-					else
-					{
-						txtfile.seekg(-static_cast<std::streamoff>(sizeof(char8_t)), std::ios::cur);
-						data.push_back(ch);
-						std::cout << "WARNING: Unknown escape character '" << (char)ch << (char)nxch << "' at string " << linecounter << '\n';
-					}
-				}
-				else
-				{
-					if (ch == u8'[')
-					{
-						txtfile.seekg(-static_cast<std::streamoff>(sizeof(char8_t)), std::ios::cur);
-						break;
-					}
-					if (txtfile.eof())
-						break;
-					data.push_back(ch);
-				}
+				if (!data.empty())
+					ConOut() << "WARNING: Text of alias section " << id << " ignored!\n";
+				sections.push_back({ id, aliasOf, std::basic_string<CharT>() });
 			}
-
-			removeCRLF(data);
-			strMap[id] = data;
 			linecounter++;
 		}
-
-		// copy strings in index order
-		for (const auto& pair : strMap)
-		{
-			outStrings->push_back(pair.second);
-		}
-
-
-		return 0;
 	}
 
 	//
-	// Parses an ini-like formatted txt file with raw data and returns a vector to the given pointer.
+	// Moves the parsed strings out in index order.
+	// Same outcome as collecting them in a std::map: a repeated index keeps the section that came last.
+	// With outAliases, every string also gets the position of the string it shares (its own for plain sections)
+	// and alias strings are left empty. Without it, aliases are resolved by copying the shared string.
 	//
-	int ParseTxtRaw(std::filesystem::path txtFilename, std::vector<std::string>* outStrings)
+	template<typename StringT>
+	void copySections(std::vector<TxtSection<StringT>>& sections, std::vector<StringT>* outStrings, std::vector<uint32_t>* outAliases)
 	{
-		std::ifstream txtfile;
-		try
-		{
-			txtfile.open(txtFilename, std::ios::binary);
-			if (!txtfile.is_open())
-			{
-				throw std::runtime_error(strerror(errno));
-			}
-		}
-		catch (const std::exception& e)
+		auto byIndex = [](const TxtSection<StringT>& a, const TxtSection<StringT>& b) { return a.id < b.id; };
+
+		// exported texts are already in order
+		if (!std::is_sorted(sections.begin(), sections.end(), byIndex))
+			std::stable_sort(sections.begin(), sections.end(), byIndex);
+
+		size_t base = outStrings->size();
+		outStrings->reserve(base + sections.size());
+
+		bool bHasAliases = false;
+		std::vector<int> ids;       // of the kept sections, to look up alias targets
+		std::vector<int> aliasOf;
+		ids.reserve(sections.size());
+		aliasOf.reserve(sections.size());
+		for (size_t i = 0; i < sections.size(); i++)
 		{
-			std::cerr << "ERROR: Failed to open file: " << txtFilename.string() << " for reading.\n";
-			std::cerr << "Reason: " << e.what() << '\n';
-			return -1;
+			if (((i + 1) < sections.size()) && (sections[i + 1].id == sections[i].id))
+				continue;
+
+			bHasAliases |= (sections[i].aliasOf >= 0);
+			ids.push_back(sections[i].id);
+			aliasOf.push_back(sections[i].aliasOf);
+			outStrings->push_back(std::move(sections[i].data));
 		}
 
-		if (txtfile.get() != '[')
+		if (outAliases)
 		{
-			std::cerr << "ERROR: Invalid file format.\n";
-			txtfile.close();
-			return -2;
+			outAliases->reserve(outStrings->size());
+			while (outAliases->size() < outStrings->size())
+				outAliases->push_back(static_cast<uint32_t>(outAliases->size()));
 		}
 
-		txtfile.seekg(0, std::ios::beg);
+		if (!bHasAliases)
+			return;
 
-
-		// create a map of strings per index to keep them in order
-		std::map<int, std::string> strMap;
-
-		int linecounter = 0;
-
-		while (!txtfile.eof())
+		for (size_t i = 0; i < ids.size(); i++)
 		{
-			std::string line = readline(txtfile);
-
-			// trim any newline chars
-			line.erase(std::find_if(line.rbegin(), line.rend(), std::not_fn(std::function<int(int)>(::isspace))).base(), line.end());
-			if (!(!line.empty() && line.front() == '[' && line.back() == ']'))
+			if (aliasOf[i] < 0)
 				continue;
 
-			std::string idStr = line.substr(1, line.length() - 2);
-			if (!isStrNumeric(idStr))
+			// only sections with their own text can be shared. Chains ([3]=@2, [2]=@0) are followed to one,
+			// a loop gives up after visiting every section
+			size_t target = i;
+			int targetId = aliasOf[i];
+			bool bHasText = false;
+			for (size_t step = 0; step < ids.size(); step++)
 			{
-				std::cout << "WARNING: Section " << idStr << " ignored!\n";
-				continue;
-			}
-			int id = std::stoi(idStr);
-			std::string data;
-			while (!txtfile.eof())
-			{
-				char ch = txtfile.get();
-				if (ch == '[')
-				{
-					// search for the ']' character within the next 6 chars
-					int seekcount = 0;
-					bool bFoundSectionEnd = false;
-					std::string bdata;
-					for (int i = 0; i < 6; i++)
-					{
-						if (txtfile.eof())
-							break;
-						char ch2 = txtfile.get();
-						if (ch2 == ']')
-						{
-							seekcount++;
-
-							if (isStrNumeric(bdata))
-								bFoundSectionEnd = true;
-							break;
-						}
-						else
-							bdata.push_back(ch2);
-
-						seekcount++;
-					}
-
-					txtfile.seekg(-static_cast<std::streamoff>((seekcount) * sizeof(char)), std::ios::cur);
+				std::vector<int>::const_iterator it = std::lower_bound(ids.begin(), ids.end(), targetId);
+				if ((it == ids.end()) || (*it != targetId))
+					break;
 
-					if (bFoundSectionEnd)
-					{
-						txtfile.seekg(-static_cast<std::streamoff>(sizeof(char)), std::ios::cur);
-						break;
-					}
-				}
-				if (txtfile.eof())
+				target = it - ids.begin();
+				if (aliasOf[target] < 0)
+				{
+					bHasText = true;
 					break;
-				data.push_back(ch);
+				}
+				targetId = aliasOf[target];
 			}
 
-			removeCRLF(data);
-			strMap[id] = data;
-			linecounter++;
-		}
+			if (!bHasText)
+			{
+				ConOut() << "WARNING: Section " << ids[i] << " is an alias of section " << aliasOf[i] << ", which has no text. Left empty!\n";
+				continue;
+			}
 
-		// copy strings in index order
-		for (const auto& pair : strMap)
-		{
-			outStrings->push_back(pair.second);
+			if (outAliases)
+				(*outAliases)[base + i] = static_cast<uint32_t>(base + target);
+			else
+				(*outStrings)[base + i] = (*outStrings)[base + target];
 		}
+	}
 
+	//
+	// Parses an ini-like (UTF-16 LE BOM) formatted text in memory and returns a vector to the given pointer.
+	// Alias sections ("[12]=@5") share the string of another section: with outAliases they're left empty and
+	// outAliases gets the position of the shared string for every entry, otherwise the string is copied. Same for all parsers.
+	//
+	int ParseTxtU16(const uint8_t* txtData, uintmax_t txtSize, std::vector<std::u16string>* outStrings, std::vector<uint32_t>* outAliases = nullptr);
 
-		return 0;
-	}
+	//
+	// Parses an ini-like (UTF-16 LE BOM) formatted txt file and returns a vector to the given pointer.
+	//
+	int ParseTxtU16(std::filesystem::path txtFilename, std::vector<std::u16string>* outStrings, std::vector<uint32_t>* outAliases = nullptr);
+
+	//
+	// Parses an ini-like (UTF-8) formatted text in memory and returns a vector to the given pointer.
+	//
+	int ParseTxtU8(const uint8_t* txtData, uintmax_t txtSize, std::vector<std::u8string>* outStrings, std::vector<uint32_t>* outAliases = nullptr);
+
+	//
+	// Parses an ini-like (UTF-8) formatted txt file and returns a vector to the given pointer.
+	//
+	int ParseTxtU8(std::filesystem::path txtFilename, std::vector<std::u8string>* outStrings, std::vector<uint32_t>* outAliases = nullptr);
+
+	//
+	// Parses an ini-like formatted text in memory with raw data and returns a vector to the given pointer.
+	//
+	int ParseTxtRaw(const uint8_t* txtData, uintmax_t txtSize, std::vector<std::string>* outStrings, std::vector<uint32_t>* outAliases = nullptr);
+
+	//
+	// Parses an ini-like formatted txt file with raw data and returns a vector to the given pointer.
+	//
+	int ParseTxtRaw(std::filesystem::path txtFilename, std::vector<std::string>* outStrings, std::vector<uint32_t>* outAliases = nullptr);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,552 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+// tfstring_bench: times the conversion stages (intern, build, export, parse, gzip) on synthetic data
+//
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "TagForceString.hpp"
+#include "TFStringClasses.hpp"
+#include "StrResource.hpp"
+#include "StoryScript.hpp"
+#include "TxtResource.hpp"
+#include "ZlibWrapper.hpp"
+
+namespace TagForceStringBench
+{
+	struct BenchOptions
+	{
+		size_t stringCount = 20000;
+		size_t minLength = 1;
+		size_t maxLength = 256;
+		bool bSkewed = true;        // Mostly short strings with a long tail, like game text. Otherwise lengths are uniform.
+		double dupRatio = 0.2;      // Share of strings repeating (the end of) an earlier one
+		uint32_t seed = 1;
+		unsigned int iterations = 5;
+		std::string filter;         // Only run stages with this in their name
+		std::filesystem::path workFolder;
+		bool bKeep = false;
+	};
+
+	//
+	// The same strings in all three encodings
+	//
+	struct Corpus
+	{
+		std::vector<std::u16string> u16;
+		std::vector<std::u8string> u8;
+		std::vector<std::string> raw;
+		uintmax_t u16Bytes = 0;
+		uintmax_t u8Bytes = 0;
+	};
+
+	void printUsage(const char* programName)
+	{
+		std::cout << "Usage: " << programName << " [OPTIONS]\n\n"
+			<< "OPTIONS:\n"
+			<< "  -n, --strings N       Strings per corpus (default 20000)\n"
+			<< "      --min-len N       Shortest string in characters (default 1)\n"
+			<< "      --max-len N       Longest string in characters (default 256)\n"
+			<< "      --uniform         Uniform string lengths (default is mostly short strings with a long tail)\n"
+			<< "      --dup-ratio R     Share of strings that repeat an earlier string or its end, 0 to 1 (default 0.2)\n"
+			<< "      --seed N          Random seed (default 1)\n"
+			<< "  -i, --iterations N    Runs per stage, the best one is reported (default 5)\n"
+			<< "      --only TEXT       Only run the stages with TEXT in their name (e.g. gzip, export/lang)\n"
+			<< "      --work DIR        Folder for the generated files (default is in the temp folder)\n"
+			<< "      --keep            Don't delete the generated files\n";
+	}
+
+	bool parseCommandLine(int argc, char* argv[], BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+			auto number = [&](double& out)
+			{
+				char* end = nullptr;
+				out = value ? strtod(value, &end) : 0.0;
+				if ((value == nullptr) || (end == value) || (*end != '\0') || (out < 0))
+				{
+					std::cerr << "Missing or invalid value for " << arg << ".\n";
+					return false;
+				}
+
+				i++;
+				return true;
+			};
+
+			double num = 0.0;
+			if ((arg == "-n") || (arg == "--strings"))
+			{
+				if (!number(num) || (num < 1))
+					return false;
+				options.stringCount = (size_t)num;
+			}
+			else if (arg == "--min-len")
+			{
+				if (!number(num))
+					return false;
+				options.minLength = (size_t)num;
+			}
+			else if (arg == "--max-len")
+			{
+				if (!number(num) || (num < 1))
+					return false;
+				options.maxLength = (size_t)num;
+			}
+			else if (arg == "--uniform")
+			{
+				options.bSkewed = false;
+			}
+			else if (arg == "--dup-ratio")
+			{
+				if (!number(num) || (num > 1.0))
+					return false;
+				options.dupRatio = num;
+			}
+			else if (arg == "--seed")
+			{
+				if (!number(num))
+					return false;
+				options.seed = (uint32_t)num;
+			}
+			else if ((arg == "-i") || (arg == "--iterations"))
+			{
+				if (!number(num) || (num < 1))
+					return false;
+				options.iterations = (unsigned int)num;
+			}
+			else if ((arg == "--only") && value)
+			{
+				options.filter = argv[++i];
+			}
+			else if ((arg == "--work") && value)
+			{
+				options.workFolder = argv[++i];
+			}
+			else if (arg == "--keep")
+			{
+				options.bKeep = true;
+			}
+			else
+			{
+				printUsage(argv[0]);
+				return false;
+			}
+		}
+
+		if (options.minLength > options.maxLength)
+		{
+			std::cerr << "--min-len can't be more than --max-len.\n";
+			return false;
+		}
+
+		if (options.workFolder.empty())
+			options.workFolder = std::filesystem::temp_directory_path() / "tfstring_bench";
+
+		return true;
+	}
+
+	static char16_t RandomChar(std::mt19937& rng)
+	{
+		static const char ascii[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789      .,!?'-";
+
+		uint32_t pick = rng() % 100;
+		if (pick < 70)
+			return ascii[rng() % (sizeof(ascii) - 1)];
+		if (pick < 73)
+			return u'\n';
+		if (pick < 88)
+			return (char16_t)(0x3041 + (rng() % (0x30FF - 0x3041)));    // kana
+		return (char16_t)(0x4E00 + (rng() % (0x9FFF - 0x4E00)));        // kanji
+	}
+
+	static size_t RandomLength(std::mt19937& rng, const BenchOptions& options)
+	{
+		if (!options.bSkewed)
+			return options.minLength + (rng() % (options.maxLength - options.minLength + 1));
+
+		// exponential with the mean at a quarter of the range, cut off at the longest length
+		std::exponential_distribution<double> dist(4.0 / (double)(options.maxLength - options.minLength + 1));
+		return std::min(options.maxLength, options.minLength + (size_t)dist(rng));
+	}
+
+	static std::u8string ToUTF8(const std::u16string& str)
+	{
+		// the generator only makes BMP characters, no surrogates
+		std::u8string out;
+		out.reserve(str.size() * 3);
+		for (char16_t ch : str)
+		{
+			if (ch < 0x80)
+			{
+				out.push_back((char8_t)ch);
+			}
+			else if (ch < 0x800)
+			{
+				out.push_back((char8_t)(0xC0 | (ch >> 6)));
+				out.push_back((char8_t)(0x80 | (ch & 0x3F)));
+			}
+			else
+			{
+				out.push_back((char8_t)(0xE0 | (ch >> 12)));
+				out.push_back((char8_t)(0x80 | ((ch >> 6) & 0x3F)));
+				out.push_back((char8_t)(0x80 | (ch & 0x3F)));
+			}
+		}
+
+		return out;
+	}
+
+	static Corpus MakeCorpus(const BenchOptions& options)
+	{
+		Corpus corpus;
+		std::mt19937 rng(options.seed);
+		std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+		corpus.u16.reserve(options.stringCount);
+		for (size_t i = 0; i < options.stringCount; i++)
+		{
+			if ((i > 0) && (chance(rng) < options.dupRatio))
+			{
+				// most repeats are whole strings, the rest are endings of others (what tail merging catches)
+				const std::u16string& earlier = corpus.u16[rng() % i];
+				if (((rng() % 4) == 0) && (earlier.size() > 1))
+					corpus.u16.push_back(earlier.substr(1 + (rng() % (earlier.size() - 1))));
+				else
+					corpus.u16.push_back(earlier);
+				continue;
+			}
+
+			std::u16string str(RandomLength(rng, options), u' ');
+			for (char16_t& ch : str)
+				ch = RandomChar(rng);
+			corpus.u16.push_back(std::move(str));
+		}
+
+		for (const auto& str : corpus.u16)
+		{
+			corpus.u8.push_back(ToUTF8(str));
+			corpus.raw.push_back(std::string(corpus.u8.back().begin(), corpus.u8.back().end()));
+			corpus.u16Bytes += str.size() * sizeof(char16_t);
+			corpus.u8Bytes += corpus.u8.back().size();
+		}
+
+		return corpus;
+	}
+
+	static std::vector<uint8_t> ReadWholeFile(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	//
+	// Runs stages and prints one result line per stage
+	//
+	class Bench
+	{
+	private:
+		const BenchOptions& options;
+
+	public:
+		// results of the stages end up here, so the compiler can't drop the work
+		uintmax_t sink = 0;
+		bool bFailed = false;
+
+		explicit Bench(const BenchOptions& opts) : options(opts)
+		{
+			char line[160];
+			snprintf(line, sizeof(line), "%-24s %9s %9s %10s %10s %14s\n", "STAGE", "STRINGS", "MB", "BEST ms", "MB/s", "strings/s");
+			std::cout << line;
+		}
+
+		//
+		// body does one run and returns the bytes it processed, or -1 if it failed
+		//
+		void run(const std::string& name, size_t strings, const std::function<intmax_t()>& body)
+		{
+			if (bFailed || (!options.filter.empty() && (name.find(options.filter) == std::string::npos)))
+				return;
+
+			double bestMs = std::numeric_limits<double>::max();
+			intmax_t bytes = 0;
+			for (unsigned int i = 0; i < options.iterations; i++)
+			{
+				auto start = std::chrono::steady_clock::now();
+				bytes = body();
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				bestMs = std::min(bestMs, ms);
+
+				if (bytes < 0)
+				{
+					std::cerr << "ERROR: Stage " << name << " failed!\n";
+					bFailed = true;
+					return;
+				}
+			}
+
+			double seconds = std::max(bestMs, 1e-6) / 1000.0;
+			double mb = (double)bytes / (1024.0 * 1024.0);
+
+			char line[160];
+			snprintf(line, sizeof(line), "%-24s %9zu %9.2f %10.3f %10.1f %14.0f\n", name.c_str(), strings, mb, bestMs, mb / seconds, (double)strings / seconds);
+			std::cout << line;
+		}
+	};
+
+	int Run(const BenchOptions& options)
+	{
+		namespace fs = std::filesystem;
+
+		Corpus corpus = MakeCorpus(options);
+		size_t n = corpus.u16.size();
+
+		std::cout << "Corpus: " << n << " strings, " << options.minLength << " - " << options.maxLength << " characters ("
+			<< (options.bSkewed ? "skewed" : "uniform") << "), " << options.dupRatio * 100.0 << "% repeats, "
+			<< corpus.u16Bytes << " bytes as UTF-16, " << corpus.u8Bytes << " bytes as UTF-8\n\n";
+
+		try
+		{
+			fs::create_directories(options.workFolder);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "ERROR: Folder " << options.workFolder.string() << " could not be created!\n";
+			std::cerr << "Reason: " << e.what() << '\n';
+			return -2;
+		}
+
+		// the converters report every file they touch, that's not what's being measured
+		std::ostringstream discard;
+		std::ostream* pOldOut = TagForceString::SetConOut(&discard);
+
+		const fs::path work = options.workFolder;
+		Bench bench(options);
+
+		//
+		// Interning: deduplicating strings into one buffer
+		//
+		bench.run("intern/u16", n, [&]
+		{
+			StringBuffer buffer;
+			uintmax_t saved = 0;
+			bench.sink += buffer.addStrings(corpus.u16, false, saved).size();
+			return (intmax_t)corpus.u16Bytes;
+		});
+		bench.run("intern/u16+tail", n, [&]
+		{
+			StringBuffer buffer;
+			uintmax_t saved = 0;
+			bench.sink += buffer.addStrings(corpus.u16, true, saved).size() + saved;
+			return (intmax_t)corpus.u16Bytes;
+		});
+		bench.run("intern/u8", n, [&]
+		{
+			StringBuffer buffer;
+			uintmax_t saved = 0;
+			bench.sink += buffer.addStrings(corpus.u8, false, saved).size();
+			return (intmax_t)corpus.u8Bytes;
+		});
+		bench.run("intern/raw", n, [&]
+		{
+			StringBuffer buffer;
+			uintmax_t saved = 0;
+			bench.sink += buffer.addStrings(corpus.raw, false, saved).size();
+			return (intmax_t)corpus.u8Bytes;
+		});
+
+		//
+		// Building resources, and writing the files for the export stages
+		//
+		auto buildStage = [&](const std::string& name, auto makeResource, auto* strings, uintmax_t bytes, bool bTailMerge)
+		{
+			bench.run(name, n, [&]
+			{
+				auto resource = makeResource();
+				resource.build(strings, bTailMerge);
+				return (intmax_t)bytes;
+			});
+		};
+
+		buildStage("build/strtbl-u16", [] { return YgStringResource(); }, &corpus.u16, corpus.u16Bytes, false);
+		buildStage("build/strtbl-u16+tail", [] { return YgStringResource(); }, &corpus.u16, corpus.u16Bytes, true);
+		buildStage("build/strtbl-u8", [] { return YgStringResource(); }, &corpus.u8, corpus.u8Bytes, false);
+		buildStage("build/strtbl-raw", [] { return YgStringResource(); }, &corpus.raw, corpus.u8Bytes, false);
+		buildStage("build/lang-u16", [] { return TFStoryScript(); }, &corpus.u16, corpus.u16Bytes, false);
+		buildStage("build/lang-u16+tail", [] { return TFStoryScript(); }, &corpus.u16, corpus.u16Bytes, true);
+		buildStage("build/lang-u8", [] { return TFStoryScript(); }, &corpus.u8, corpus.u8Bytes, false);
+		buildStage("build/lang-raw", [] { return TFStoryScript(); }, &corpus.raw, corpus.u8Bytes, false);
+
+		// text resources have no tail merging
+		bench.run("build/txtres-u16", n, [&] { YgTextResource res; res.build(&corpus.u16); return (intmax_t)corpus.u16Bytes; });
+		bench.run("build/txtres-u8", n, [&] { YgTextResource res; res.build(&corpus.u8); return (intmax_t)corpus.u8Bytes; });
+		bench.run("build/txtres-raw", n, [&] { YgTextResource res; res.build(&corpus.raw); return (intmax_t)corpus.u8Bytes; });
+
+		try
+		{
+			{ YgStringResource res; res.build(&corpus.u16); res.exportFile(work / "strtbl_u16.bin"); }
+			{ YgStringResource res; res.build(&corpus.u8); res.exportFile(work / "strtbl_u8.bin"); }
+			{ YgStringResource res; res.build(&corpus.raw); res.exportFile(work / "strtbl_raw.bin"); }
+			{ YgTextResource res; res.build(&corpus.u16); res.exportFile(work / "txtres_u16.bin"); }
+			{ YgTextResource res; res.build(&corpus.u8); res.exportFile(work / "txtres_u8.bin"); }
+			{ YgTextResource res; res.build(&corpus.raw); res.exportFile(work / "txtres_raw.bin"); }
+			{ TFStoryScript tfs; tfs.build(&corpus.u16); tfs.exportFile(work / "langI_u16.bin", work / "langL_u16.bin"); }
+			{ TFStoryScript tfs; tfs.build(&corpus.u8); tfs.exportFile(work / "langI_u8.bin", work / "langL_u8.bin"); }
+			{ TFStoryScript tfs; tfs.build(&corpus.raw); tfs.exportFile(work / "langI_raw.bin", work / "langL_raw.bin"); }
+		}
+		catch (const std::exception& e)
+		{
+			TagForceString::SetConOut(pOldOut);
+			std::cerr << "ERROR: Can't write the corpus files to: " << work.string() << '\n';
+			std::cerr << "Reason: " << e.what() << '\n';
+			return -2;
+		}
+
+		//
+		// Exporting to txt, from the file on disk to the file on disk
+		//
+		auto exportStage = [&](const std::string& name, const fs::path& txtPath, const std::function<int()>& convert)
+		{
+			bench.run(name, n, [&]
+			{
+				if (convert() < 0)
+					return (intmax_t)-1;
+				return (intmax_t)fs::file_size(txtPath);
+			});
+		};
+
+		exportStage("export/strtbl-u16", work / "strtbl_u16.txt", [&] { return StrResource::ExportU16(work / "strtbl_u16.bin", work / "strtbl_u16.txt"); });
+		exportStage("export/strtbl-u8", work / "strtbl_u8.txt", [&] { return StrResource::ExportU8(work / "strtbl_u8.bin", work / "strtbl_u8.txt"); });
+		exportStage("export/strtbl-raw", work / "strtbl_raw.txt", [&] { return StrResource::ExportRaw(work / "strtbl_raw.bin", work / "strtbl_raw.txt"); });
+		exportStage("export/txtres-u16", work / "txtres_u16.txt", [&] { return TxtResource::ExportU16(work / "txtres_u16.bin", work / "txtres_u16.txt"); });
+		exportStage("export/txtres-u8", work / "txtres_u8.txt", [&] { return TxtResource::ExportU8(work / "txtres_u8.bin", work / "txtres_u8.txt"); });
+		exportStage("export/txtres-raw", work / "txtres_raw.txt", [&] { return TxtResource::ExportRaw(work / "txtres_raw.bin", work / "txtres_raw.txt"); });
+		exportStage("export/lang-u16", work / "lang_u16.txt", [&] { return StoryScript::ExportU16(work / "langI_u16.bin", work / "langL_u16.bin", work / "lang_u16.txt"); });
+		exportStage("export/lang-u8", work / "lang_u8.txt", [&] { return StoryScript::ExportU8(work / "langI_u8.bin", work / "langL_u8.bin", work / "lang_u8.txt"); });
+		exportStage("export/lang-raw", work / "lang_raw.txt", [&] { return StoryScript::ExportRaw(work / "langI_raw.bin", work / "langL_raw.bin", work / "lang_raw.txt"); });
+
+		//
+		// Parsing txt files that are already in memory
+		//
+		// the export stages might have been filtered out
+		if (!fs::exists(work / "strtbl_u16.txt"))
+			StrResource::ExportU16(work / "strtbl_u16.bin", work / "strtbl_u16.txt");
+		if (!fs::exists(work / "strtbl_u8.txt"))
+			StrResource::ExportU8(work / "strtbl_u8.bin", work / "strtbl_u8.txt");
+		if (!fs::exists(work / "strtbl_raw.txt"))
+			StrResource::ExportRaw(work / "strtbl_raw.bin", work / "strtbl_raw.txt");
+
+		std::vector<uint8_t> txtU16 = ReadWholeFile(work / "strtbl_u16.txt");
+		std::vector<uint8_t> txtU8 = ReadWholeFile(work / "strtbl_u8.txt");
+		std::vector<uint8_t> txtRaw = ReadWholeFile(work / "strtbl_raw.txt");
+
+		bench.run("parse/u16", n, [&]
+		{
+			std::vector<std::u16string> strings;
+			if (TagForceString::ParseTxtU16(txtU16.data(), txtU16.size(), &strings) < 0)
+				return (intmax_t)-1;
+			bench.sink += strings.size();
+			return (intmax_t)txtU16.size();
+		});
+		bench.run("parse/u8", n, [&]
+		{
+			std::vector<std::u8string> strings;
+			if (TagForceString::ParseTxtU8(txtU8.data(), txtU8.size(), &strings) < 0)
+				return (intmax_t)-1;
+			bench.sink += strings.size();
+			return (intmax_t)txtU8.size();
+		});
+		bench.run("parse/raw", n, [&]
+		{
+			std::vector<std::string> strings;
+			if (TagForceString::ParseTxtRaw(txtRaw.data(), txtRaw.size(), &strings) < 0)
+				return (intmax_t)-1;
+			bench.sink += strings.size();
+			return (intmax_t)txtRaw.size();
+		});
+
+		//
+		// gzip both ways, on a lang file like the ones folder mode compresses
+		//
+		std::vector<uint8_t> langData = ReadWholeFile(work / "langL_u16.bin");
+		fs::path gzPath = work / "langL_u16.bin.gz";
+
+		auto packStage = [&](const std::string& name, const ZLibWrapper::GzParams& params)
+		{
+			bench.run(name, n, [&]
+			{
+				try
+				{
+					ZLibWrapper::packGzFile(langData.data(), langData.size(), gzPath, params);
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "Reason: " << e.what() << '\n';
+					return (intmax_t)-1;
+				}
+				return (intmax_t)langData.size();
+			});
+		};
+
+		packStage("gzip/pack-fast", ZLibWrapper::GzParams::fast());
+		packStage("gzip/pack-best", ZLibWrapper::GzParams::best());
+		packStage("gzip/pack-default", ZLibWrapper::GzParams());
+
+		// the pack stages might have been filtered out too
+		if (!fs::exists(gzPath))
+			ZLibWrapper::packGzFile(langData.data(), langData.size(), gzPath);
+
+		bench.run("gzip/extract", n, [&]
+		{
+			std::vector<uint8_t> inflated;
+			try
+			{
+				ZLibWrapper::extractGzFile(gzPath, inflated);
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "Reason: " << e.what() << '\n';
+				return (intmax_t)-1;
+			}
+			return (intmax_t)inflated.size();
+		});
+
+		TagForceString::SetConOut(pOldOut);
+
+		if (!options.bKeep)
+		{
+			std::error_code ec;
+			fs::remove_all(options.workFolder, ec);
+		}
+
+		return bench.bFailed ? -1 : 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::cout << "Yu-Gi-Oh! Tag Force Language & String Tool - Benchmark\n\n";
+
+	TagForceStringBench::BenchOptions options;
+	if (!TagForceStringBench::parseCommandLine(argc, argv, options))
+		return 1;
+
+	return TagForceStringBench::Run(options);
+}
@@ -0,0 +1,632 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include "TagForceStringCli.hpp"
+#include "StrResource.hpp"
+#include "StoryScript.hpp"
+#include "TxtResource.hpp"
+#include "TF1Folder.hpp"
+#include "Json.hpp"
+
+namespace TagForceString
+{
+	void printUsage(const char* programName)
+	{
+		std::cerr << "Usage: " << programName << " [OPTIONS] MODE INPUT OUTPUT\n"
+			<< "\nOPTIONS:\n"
+			<< "  -u, --utf8          Use UTF-8 / 8-bit encoding (default is UTF-16)\n"
+			<< "  -d, --no-bom        Disable BOM autodetection for input text files and BOM writing for output\n"
+			<< "  -r, --raw           Treat string data as raw data. Useful for Shift-JIS.\n"
+			<< "  -j, --jobs N        Convert up to N file pairs at once in folder modes (0 = all CPU threads, default is 1)\n"
+			<< "      --tail-merge    Store strings that end another string inside of it (smaller strtbl and lang files)\n"
+			<< "      --gz-level L    Compression for .bin.gz output in folder mode: fast or best (default is zlib's default)\n"
+			<< "      --incremental   Folder modes: skip files that didn't change since the last run (keeps a .tfstring-cache file in the output folder)\n"
+			<< "      --aliases       Text output: write a string shared by several entries once, the others become [N]=@M alias sections\n"
+			<< "      --stats         Print how much time each stage (open, parse, build, write...) took when done\n"
+			<< "      --stats-json F  Write the stage timings and counters to the file F as JSON\n"
+			<< "      --trace F       Record a trace of every file pair and stage (with thread IDs) to the file F, for chrome://tracing or Perfetto\n"
+			<< "\nSTRING RESOURCE MODES:\n"
+			<< "  bin2txt           Convert a string resource (strtbl) file to a text file\n"
+			<< "  txt2bin           Convert a text file to a string resource (strtbl) file\n"
+			<< "\nTEXT RESOURCE MODES:\n"
+			<< "  tbin2txt          Convert a text resource (e.g. tutorial) file to a text file\n"
+			<< "  txt2tbin          Convert a text file to a text resource (e.g. tutorial) file\n"
+			<< "\nLANG FILE MODES:\n"
+			<< "  lang2txt          Convert a pair of lang files (index and strings) to a text file\n"
+			<< "  txt2lang          Convert a text file to a pair of lang files (index and strings)\n"
+			<< "\nFOLDER MODES:\n"
+			<< "  fold2txt          Batch convert a folder with lang file pairs to a folder with text files\n"
+			<< "  txt2fold          Batch convert a folder with text files to a folder with lang file pairs\n"
+			<< "\nSERVER MODE:\n"
+			<< "  serve             Keep running and convert jobs sent as JSON lines on stdin (results go to stdout)\n"
+			<< "      --socket PATH   Listen on a Unix socket instead of stdin (not on Windows)\n"
+			<< "      -j N            Run up to N jobs at once (0 = all CPU threads, default is 1)\n"
+			<< "\nBATCH MODE:\n"
+			<< "  batch MANIFEST    Run the jobs listed in a JSON manifest (an array, or one job per line) and print a status table\n"
+			<< "      -j N            Run up to N jobs at once (0 = all CPU threads, default is 1)\n"
+			<< "\nEXAMPLES:\n"
+			<< "  " << programName << " bin2txt input_e.bin output.txt\n"
+			<< "  " << programName << " txt2bin input.txt output_e.bin\n"
+			<< "  " << programName << " lang2txt langIe.bin langLe.bin output.txt\n"
+			<< "  " << programName << " --utf8 txt2lang input.txt outIe.bin outLe.bin\n"
+			<< "  " << programName << " fold2txt in_folder out_folder\n"
+			<< "  " << programName << " txt2fold in_folder out_folder\n"
+			<< "  " << programName << " -j 0 serve < jobs.ndjson\n"
+			<< "  " << programName << " -j 0 batch manifest.json\n"
+			<< "\nNOTES:\n"
+			<< " - Folder modes MUST follow the correct filename format! (e.g. langIe.bin & langLe.bin & lang_e.txt)\n"
+			<< " - The encoding must match on both input and output files! The tool does not perform any conversion!\n"
+			<< "For more information, please read the README."
+			<< '\n';
+	}
+
+	static const struct
+	{
+		const char* name;
+		OperatingMode mode;
+	} modeNames[] =
+	{
+		{ "bin2txt", BIN2TXT },
+		{ "txt2bin", TXT2BIN },
+		{ "tbin2txt", TBIN2TXT },
+		{ "txt2tbin", TXT2TBIN },
+		{ "lang2txt", LANG2TXT },
+		{ "txt2lang", TXT2LANG },
+		{ "fold2txt", FOLD2TXT },
+		{ "txt2fold", TXT2FOLD },
+		{ "serve", SERVE },
+		{ "batch", BATCH },
+	};
+
+	bool ModeFromName(std::string_view name, OperatingMode& mode)
+	{
+		for (const auto& entry : modeNames)
+		{
+			if (name == entry.name)
+			{
+				mode = entry.mode;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	const char* ModeName(OperatingMode mode)
+	{
+		for (const auto& entry : modeNames)
+		{
+			if (mode == entry.mode)
+				return entry.name;
+		}
+
+		return "unknown";
+	}
+
+	Options parseCommandLine(int argc, char* argv[])
+	{
+		Options options;
+		bool bModeSet = false;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+
+			// only the first mode name picks the mode, after that it's just a file called e.g. "serve"
+			OperatingMode argMode;
+			bool bModeArg = !bModeSet && ModeFromName(arg, argMode);
+			bModeSet |= bModeArg;
+
+			if (arg == "-u" || arg == "--utf8")
+			{
+				options.useUTF8 = true;
+			}
+			else if (arg == "-d" || arg == "--no-bom")
+			{
+				options.useBOM = false;
+			}
+			else if (arg == "-r" || arg == "--raw")
+			{
+				options.useRAW = true;
+			}
+			else if (arg == "--tail-merge")
+			{
+				options.tailMerge = true;
+			}
+			else if (arg == "--incremental")
+			{
+				options.incremental = true;
+			}
+			else if (arg == "--aliases")
+			{
+				options.aliases = true;
+			}
+			else if (arg == "--stats")
+			{
+				options.stats = true;
+			}
+			else if (arg == "--stats-json")
+			{
+				if (i + 1 >= argc)
+				{
+					std::cerr << "Missing path for " << arg << ". Use '" << argv[0] << "' for help.\n";
+					exit(1);
+				}
+
+				options.statsJsonPath = argv[++i];
+			}
+			else if (arg == "--trace")
+			{
+				if (i + 1 >= argc)
+				{
+					std::cerr << "Missing path for " << arg << ". Use '" << argv[0] << "' for help.\n";
+					exit(1);
+				}
+
+				options.tracePath = argv[++i];
+			}
+			else if (arg == "--gz-level")
+			{
+				std::string level = (i + 1 < argc) ? argv[i + 1] : "";
+				if (level == "fast")
+					options.gzLevel = GZ_FAST;
+				else if (level == "best")
+					options.gzLevel = GZ_BEST;
+				else
+				{
+					std::cerr << "Missing or invalid level for " << arg << " (use fast or best). Use '" << argv[0] << "' for help.\n";
+					exit(1);
+				}
+
+				i++;
+			}
+			else if (arg == "-j" || arg == "--jobs")
+			{
+				char* end = nullptr;
+				unsigned long jobs = (i + 1 < argc) ? strtoul(argv[i + 1], &end, 10) : 0;
+				if ((end == nullptr) || (end == argv[i + 1]) || (*end != '\0'))
+				{
+					std::cerr << "Missing or invalid job count for " << arg << ". Use '" << argv[0] << "' for help.\n";
+					exit(1);
+				}
+
+				options.jobs = jobs;
+				i++;
+			}
+			else if (bModeArg && (arg == "bin2txt"))
+			{
+				options.mode = BIN2TXT;
+			}
+			else if (bModeArg && (arg == "txt2bin"))
+			{
+				options.mode = TXT2BIN;
+			}
+			else if (bModeArg && (arg == "tbin2txt"))
+			{
+				options.mode = TBIN2TXT;
+			}
+			else if (bModeArg && (arg == "txt2tbin"))
+			{
+				options.mode = TXT2TBIN;
+			}
+			else if (bModeArg && (arg == "fold2txt"))
+			{
+				options.mode = FOLD2TXT;
+			}
+			else if (bModeArg && (arg == "txt2fold"))
+			{
+				options.mode = TXT2FOLD;
+			}
+			else if (bModeArg && (arg == "serve"))
+			{
+				options.mode = SERVE;
+			}
+			else if (bModeArg && (arg == "batch"))
+			{
+				options.mode = BATCH;
+				if (i + 1 < argc)
+				{
+					options.inputFilePath1 = argv[++i];
+				}
+				else
+				{
+					std::cerr << "Missing manifest for batch. Use '" << argv[0] << "' for help.\n";
+					exit(1);
+				}
+			}
+			else if (arg == "--socket")
+			{
+				if (i + 1 >= argc)
+				{
+					std::cerr << "Missing path for " << arg << ". Use '" << argv[0] << "' for help.\n";
+					exit(1);
+				}
+
+				options.socketPath = argv[++i];
+			}
+			else if (bModeArg && (arg == "lang2txt"))
+			{
+				options.mode = LANG2TXT;
+				if (i + 3 < argc)
+				{
+					options.inputFilePath1 = argv[++i];
+					options.inputFilePath2 = argv[++i];
+					options.outputFilePath1 = argv[++i];
+				}
+				else
+				{
+					std::cerr << "Insufficient arguments for lang2txt. Use '" << argv[0] << "' for help.\n";
+					//printUsage(argv[0]);
+					exit(1);
+				}
+			}
+			else if (bModeArg && (arg == "txt2lang"))
+			{
+				options.mode = TXT2LANG;
+				if (i + 3 < argc)
+				{
+					options.inputFilePath1 = argv[++i];
+					options.outputFilePath1 = argv[++i];
+					options.outputFilePath2 = argv[++i];
+				}
+				else
+				{
+					std::cerr << "Insufficient arguments for txt2lang. Use '" << argv[0] << "' for help.\n";
+					//printUsage(argv[0]);
+					exit(1);
+				}
+			}
+			else if (i + 2 <= argc)
+			{
+				options.inputFilePath1 = argv[i++];
+				options.outputFilePath1 = argv[i++];
+			}
+			else
+			{
+				std::cerr << "Invalid arguments. Use '" << argv[0] << "' for help.\n";
+				//printUsage(argv[0]);
+				exit(1);
+			}
+		}
+
+		return options;
+	}
+
+	int RunOptions(Options options)
+	{
+		UnicodeBOMType curBOM = UnicodeBOMType::BOM_UNKNOWN;
+
+		if (options.useUTF8)
+			ConOut() << "UTF-8 mode enabled!\n";
+
+		if (((options.mode == OperatingMode::TXT2BIN) || (options.mode == OperatingMode::TXT2LANG))
+			&& (options.useBOM && !options.useUTF8))
+		{
+			try
+			{
+				curBOM = GetBOM(options.inputFilePath1);
+			}
+			catch (const std::exception& e)
+			{
+				ConErr() << "ERROR: Failed to open file: " << options.inputFilePath1.string() << " for reading.\n";
+				ConErr() << "Reason: " << e.what() << '\n';
+				return -1;
+			}
+
+			ConOut() << "BOM: ";
+			switch (curBOM)
+			{
+				case UnicodeBOMType::BOM_UTF8:
+				{
+					ConOut() << "UTF-8";
+					options.useUTF8 = true;
+					break;
+				}
+
+				case UnicodeBOMType::BOM_UTF16LE:
+				{
+					ConOut() << "UTF-16 Little Endian";
+					break;
+				}
+
+				case UnicodeBOMType::BOM_UTF16BE:
+				{
+					ConOut() << "UTF-16 Big Endian";
+					break;
+				}
+
+				default:
+				{
+					ConOut() << "Unknown";
+					break;
+				}
+			}
+
+			ConOut() << '\n';
+
+			if (curBOM == UnicodeBOMType::BOM_UTF16BE)
+			{
+				ConErr() << "Big endian BOM detected! Please only use little endian files!\n";
+				return 2;
+			}
+		}
+
+		switch (options.mode)
+		{
+			case OperatingMode::BIN2TXT:
+			{
+				ConOut() << "Converting: " << '\n'
+					<< " <- " << options.inputFilePath1.string() << '\n'
+					<< " -> " << options.outputFilePath1.string() << '\n';
+				if (options.useRAW)
+					return StrResource::ExportRaw(options.inputFilePath1, options.outputFilePath1, options.aliases);
+				if (options.useUTF8)
+					return StrResource::ExportU8(options.inputFilePath1, options.outputFilePath1, options.useBOM, options.aliases);
+				else
+					return StrResource::ExportU16(options.inputFilePath1, options.outputFilePath1, options.useBOM, options.aliases);
+
+				break;
+			}
+
+			case OperatingMode::TXT2BIN:
+			{
+				ConOut() << "Converting: " << '\n'
+					<< " <- " << options.inputFilePath1.string() << '\n'
+					<< " -> " << options.outputFilePath1.string() << '\n';
+				if (options.useRAW)
+					return StrResource::ImportRaw(options.inputFilePath1, options.outputFilePath1, options.tailMerge);
+				if (options.useUTF8)
+					return StrResource::ImportU8(options.inputFilePath1, options.outputFilePath1, options.tailMerge);
+				else
+					return StrResource::ImportU16(options.inputFilePath1, options.outputFilePath1, options.tailMerge);
+
+				break;
+			}
+
+			case OperatingMode::TBIN2TXT:
+			{
+				ConOut() << "Converting: " << '\n'
+					<< " <- " << options.inputFilePath1.string() << '\n'
+					<< " -> " << options.outputFilePath1.string() << '\n';
+				if (options.useRAW)
+					return TxtResource::ExportRaw(options.inputFilePath1, options.outputFilePath1, options.aliases);
+				if (options.useUTF8)
+					return TxtResource::ExportU8(options.inputFilePath1, options.outputFilePath1, options.useBOM, options.aliases);
+				else
+					return TxtResource::ExportU16(options.inputFilePath1, options.outputFilePath1, options.useBOM, options.aliases);
+
+				break;
+			}
+
+			case OperatingMode::TXT2TBIN:
+			{
+				ConOut() << "Converting: " << '\n'
+					<< " <- " << options.inputFilePath1.string() << '\n'
+					<< " -> " << options.outputFilePath1.string() << '\n';
+				// text resource items carry their own sizes, so their strings can't overlap
+				if (options.tailMerge)
+					ConOut() << "WARNING: --tail-merge is ignored for text resources!\n";
+				if (options.useRAW)
+					return TxtResource::ImportRaw(options.inputFilePath1, options.outputFilePath1);
+				if (options.useUTF8)
+					return TxtResource::ImportU8(options.inputFilePath1, options.outputFilePath1);
+				else
+					return TxtResource::ImportU16(options.inputFilePath1, options.outputFilePath1);
+
+				break;
+			}
+
+			case OperatingMode::LANG2TXT:
+			{
+				ConOut() << "Converting: " << '\n'
+					<< " <- " << options.inputFilePath1.string() << '\n'
+					<< " <- " << options.inputFilePath2.string() << '\n'
+					<< " -> " << options.outputFilePath1.string() << '\n';
+				if (options.useRAW)
+					return StoryScript::ExportRaw(options.inputFilePath1, options.inputFilePath2, options.outputFilePath1, options.aliases);
+				if (options.useUTF8)
+					return StoryScript::ExportU8(options.inputFilePath1, options.inputFilePath2, options.outputFilePath1, options.useBOM, options.aliases);
+				else
+					return StoryScript::ExportU16(options.inputFilePath1, options.inputFilePath2, options.outputFilePath1, options.useBOM, options.aliases);
+
+				break;
+			}
+
+			case OperatingMode::TXT2LANG:
+			{
+				ConOut() << "Converting: " << '\n'
+					<< " <- " << options.inputFilePath1.string() << '\n'
+					<< " -> " << options.outputFilePath1.string() << '\n'
+					<< " -> " << options.outputFilePath2.string() << '\n';
+				if (options.useRAW)
+					return StoryScript::ImportRaw(options.inputFilePath1, options.outputFilePath1, options.outputFilePath2, options.tailMerge);
+				if (options.useUTF8)
+					return StoryScript::ImportU8(options.inputFilePath1, options.outputFilePath1, options.outputFilePath2, options.tailMerge);
+				else
+					return StoryScript::ImportU16(options.inputFilePath1, options.outputFilePath1, options.outputFilePath2, options.tailMerge);
+
+				break;
+			}
+
+			case OperatingMode::FOLD2TXT:
+			{
+				ConOut() << "Converting: " << '\n'
+					<< " <- " << options.inputFilePath1.string() << '\n'
+					<< " -> " << options.outputFilePath1.string() << '\n';
+				if (options.useRAW)
+					return TF1Folder::ExportFolderRaw(options.inputFilePath1, options.outputFilePath1, options.jobs, options.incremental, options.aliases);
+				if (options.useUTF8)
+					return TF1Folder::ExportFolderU8(options.inputFilePath1, options.outputFilePath1, options.jobs, options.incremental, options.aliases);
+				else
+					return TF1Folder::ExportFolderU16(options.inputFilePath1, options.outputFilePath1, options.jobs, options.incremental, options.aliases);
+
+				break;
+			}
+
+			case OperatingMode::TXT2FOLD:
+			{
+				ConOut() << "Converting: " << '\n'
+					<< " <- " << options.inputFilePath1.string() << '\n'
+					<< " -> " << options.outputFilePath1.string() << '\n';
+
+				ZLibWrapper::GzParams gzParams;
+				if (options.gzLevel == GZ_FAST)
+					gzParams = ZLibWrapper::GzParams::fast();
+				else if (options.gzLevel == GZ_BEST)
+					gzParams = ZLibWrapper::GzParams::best();
+
+				if (options.useRAW)
+					return TF1Folder::ImportFolderRaw(options.inputFilePath1, options.outputFilePath1, options.jobs, options.tailMerge, gzParams, options.incremental);
+				if (options.useUTF8)
+					return TF1Folder::ImportFolderU8(options.inputFilePath1, options.outputFilePath1, options.jobs, options.tailMerge, gzParams, options.incremental);
+				else
+					return TF1Folder::ImportFolderU16(options.inputFilePath1, options.outputFilePath1, options.jobs, options.tailMerge, gzParams, options.incremental);
+
+				break;
+			}
+
+			case OperatingMode::SERVE:
+			case OperatingMode::BATCH:
+			{
+				// handled by Serve() / RunBatch(), they aren't conversions
+				ConErr() << "ERROR: " << ModeName(options.mode) << " can't run as a single conversion!\n";
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+	void PrintStats(const Stats::Totals& totals, double wallMs, std::ostream& out)
+	{
+		uint64_t totalNs = 0;
+		for (const Stats::StageTotals& stage : totals.stages)
+			totalNs += stage.nanoseconds;
+
+		char line[256];
+		snprintf(line, sizeof(line), "\n%-11s  %8s  %10s  %6s  %10s  %9s\n", "STAGE", "CALLS", "TIME (ms)", "SHARE", "MB", "MB/s");
+		out << line;
+
+		for (int i = 0; i < Stats::STAGE_COUNT; i++)
+		{
+			const Stats::StageTotals& stage = totals.stages[i];
+			double ms = stage.nanoseconds / 1e6;
+			double mb = stage.bytes / (1024.0 * 1024.0);
+			double share = totalNs ? (100.0 * stage.nanoseconds / totalNs) : 0.0;
+
+			snprintf(line, sizeof(line), "%-11s  %8llu  %10.3f  %5.1f%%  %10.2f  ", Stats::StageName((Stats::Stage)i), (unsigned long long)stage.calls, ms, share, mb);
+			out << line;
+			if ((ms > 0.0) && stage.bytes)
+				snprintf(line, sizeof(line), "%9.1f\n", mb / (ms / 1000.0));
+			else
+				snprintf(line, sizeof(line), "%9s\n", "-");
+			out << line;
+		}
+
+		snprintf(line, sizeof(line), "%-11s  %8s  %10.3f\n", "total", "", totalNs / 1e6);
+		out << line;
+
+		out << '\n' << totals.counters[Stats::COUNTER_STRINGS_PARSED] << " string(s) parsed, "
+			<< totals.counters[Stats::COUNTER_STRINGS_EXPORTED] << " exported, "
+			<< totals.counters[Stats::COUNTER_STRINGS_UNIQUE] << " stored after deduplication\n";
+		if (totals.counters[Stats::COUNTER_TAIL_MERGE_SAVED])
+			out << "Tail merging saved " << totals.counters[Stats::COUNTER_TAIL_MERGE_SAVED] << " bytes\n";
+		if (totals.counters[Stats::COUNTER_FILES_SKIPPED])
+			out << totals.counters[Stats::COUNTER_FILES_SKIPPED] << " file(s) were up to date\n";
+
+		snprintf(line, sizeof(line), "Wall time: %.3f ms (stage times are summed over all threads)\n", wallMs);
+		out << line;
+	}
+
+	bool WriteStatsJson(const Options& options, const Stats::Totals& totals, double wallMs)
+	{
+		uint64_t totalNs = 0;
+		Json::Object stages;
+		for (int i = 0; i < Stats::STAGE_COUNT; i++)
+		{
+			const Stats::StageTotals& stage = totals.stages[i];
+			totalNs += stage.nanoseconds;
+
+			Json::Object entry;
+			entry.add("calls", stage.calls)
+				.add("ms", stage.nanoseconds / 1e6)
+				.add("bytes", stage.bytes);
+			stages.addRaw(Stats::StageName((Stats::Stage)i), entry.str());
+		}
+
+		Json::Object counters;
+		for (int i = 0; i < Stats::COUNTER_COUNT; i++)
+			counters.add(Stats::CounterName((Stats::Counter)i), totals.counters[i]);
+
+		Json::Object root;
+		root.add("mode", ModeName(options.mode))
+			.add("jobs", (int64_t)options.jobs)
+			.add("wall_ms", wallMs)
+			.add("stage_ms", totalNs / 1e6)
+			.addRaw("stages", stages.str())
+			.addRaw("counters", counters.str());
+
+		std::ofstream file(options.statsJsonPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		file << root.str() << '\n';
+		return file.good();
+	}
+	bool WriteTraceJson(const Options& options, const std::vector<Stats::TraceEvent>& events)
+	{
+		std::ofstream file(options.tracePath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		// name the threads first, so the viewer doesn't just show numbers
+		uint32_t threadCount = 1;
+		for (const Stats::TraceEvent& event : events)
+			threadCount = std::max(threadCount, event.threadId + 1);
+
+		file << "{\"displayTimeUnit\":\"ms\",\"otherData\":" << Json::Object().add("mode", ModeName(options.mode)).add("jobs", (int64_t)options.jobs).str()
+			<< ",\"traceEvents\":[\n";
+
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			Json::Object threadName;
+			threadName.add("name", (i == 0) ? std::string("main") : ("worker " + std::to_string(i)));
+
+			Json::Object meta;
+			meta.add("name", "thread_name")
+				.add("ph", "M")
+				.add("pid", 1)
+				.add("tid", (int64_t)i)
+				.addRaw("args", threadName.str());
+			file << ((i == 0) ? "" : ",\n") << meta.str();
+		}
+
+		for (const Stats::TraceEvent& event : events)
+		{
+			Json::Object args;
+			if (event.bytes)
+				args.add("bytes", event.bytes);
+			if (!event.detail.empty())
+				args.add("detail", event.detail);
+
+			// timestamps are in microseconds
+			Json::Object entry;
+			entry.add("name", event.name)
+				.add("cat", event.category)
+				.add("ph", "X")
+				.add("pid", 1)
+				.add("tid", (int64_t)event.threadId)
+				.add("ts", event.startNs / 1e3)
+				.add("dur", event.durationNs / 1e3)
+				.addRaw("args", args.str());
+			file << ",\n" << entry.str();
+		}
+
+		file << "\n]}\n";
+		return file.good();
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "Stats.hpp"
+
+#ifndef TFSTRINGCLI_HDR
+#define TFSTRINGCLI_HDR
+
+//
+// Command line handling of the TagForceString tool. Not part of the library.
+//
+namespace TagForceString
+{
+	enum OperatingMode
+	{
+		BIN2TXT,
+		TXT2BIN,
+		TBIN2TXT,
+		TXT2TBIN,
+		LANG2TXT,
+		TXT2LANG,
+		FOLD2TXT,
+		TXT2FOLD,
+		SERVE,
+		BATCH
+	};
+
+	enum GzLevel
+	{
+		GZ_DEFAULT,
+		GZ_FAST,
+		GZ_BEST
+	};
+
+	struct Options
+	{
+		OperatingMode mode = BIN2TXT;
+		std::filesystem::path inputFilePath1;
+		std::filesystem::path inputFilePath2;
+		std::filesystem::path outputFilePath1;
+		std::filesystem::path outputFilePath2;
+		bool useUTF8 = false;       // Default is UTF-16
+		bool useBOM = true;
+		bool useRAW = false;
+		unsigned int jobs = 1;      // Folder modes only, 0 = one per hardware thread
+		bool tailMerge = false;     // strtbl and lang output only
+		GzLevel gzLevel = GZ_DEFAULT; // Compressed lang output in folder mode
+		bool incremental = false;   // Folder modes only, skip files that didn't change since the last run
+		bool aliases = false;       // txt output only, write shared strings once and alias sections ("[12]=@5") for the rest
+		std::filesystem::path socketPath; // Serve mode only, empty = stdin / stdout
+		bool stats = false;         // Print per-stage timings and counters when done
+		std::filesystem::path statsJsonPath; // Also write them to this file as JSON
+		std::filesystem::path tracePath; // Record a Chrome trace of the run into this file
+	};
+
+	//
+	// Looks up a mode by its command line name (e.g. "bin2txt"). Returns false for unknown names.
+	//
+	bool ModeFromName(std::string_view name, OperatingMode& mode);
+
+	const char* ModeName(OperatingMode mode);
+
+	void printUsage(const char* programName);
+
+	Options parseCommandLine(int argc, char* argv[]);
+
+	//
+	// Runs the conversion described by the options. Messages go to the console sinks (ConOut / ConErr).
+	// Returns the exit code of the tool (0 on success).
+	//
+	int RunOptions(Options options);
+
+	//
+	// Prints the stage totals collected while the stats were enabled as a table.
+	// Stage times are summed over all threads, so with several jobs they can add up to more than the wall time.
+	//
+	void PrintStats(const Stats::Totals& totals, double wallMs, std::ostream& out);
+
+	//
+	// Writes the stage totals of a run to options.statsJsonPath. Returns false if the file can't be written.
+	//
+	bool WriteStatsJson(const Options& options, const Stats::Totals& totals, double wallMs);
+
+	//
+	// Writes the recorded trace events to options.tracePath in Chrome trace event format (chrome://tracing, Perfetto).
+	// Returns false if the file can't be written.
+	//
+	bool WriteTraceJson(const Options& options, const std::vector<Stats::TraceEvent>& events);
+}
+
+#endif
\ No newline at end of file
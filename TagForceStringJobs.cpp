@@ -0,0 +1,819 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include <iostream>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <unordered_map>
+#include "TagForceString.hpp"
+#include "TagForceStringJobs.hpp"
+#include "ThreadPool.hpp"
+#include "FileBuffer.hpp"
+
+#ifndef _WIN32
+#include <thread>
+#include <csignal>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+namespace TagForceString
+{
+	//
+	// Reads a member that holds either a single path or an array of paths
+	//
+	static bool getPathList(const Json::Value& job, const char* name, std::vector<std::filesystem::path>& paths, std::string& error)
+	{
+		const Json::Value* member = job.find(name);
+		if (member == nullptr)
+			return true;
+
+		auto toPath = [](const std::string& str)
+		{
+			return std::filesystem::path(std::u8string((const char8_t*)str.data(), str.size()));
+		};
+
+		if (member->isString())
+		{
+			paths.push_back(toPath(member->str));
+			return true;
+		}
+
+		if (member->isArray())
+		{
+			for (const Json::Value& item : member->items)
+			{
+				if (!item.isString())
+				{
+					error = std::string("'") + name + "' can only contain strings";
+					return false;
+				}
+
+				paths.push_back(toPath(item.str));
+			}
+
+			return true;
+		}
+
+		error = std::string("'") + name + "' has to be a string or an array of strings";
+		return false;
+	}
+
+	static bool getBool(const Json::Value& job, const char* name, bool& value, std::string& error)
+	{
+		const Json::Value* member = job.find(name);
+		if (member == nullptr)
+			return true;
+
+		if (!member->isBool())
+		{
+			error = std::string("'") + name + "' has to be true or false";
+			return false;
+		}
+
+		value = member->boolean;
+		return true;
+	}
+
+	bool OptionsFromJson(const Json::Value& job, Options& options, std::string& error)
+	{
+		if (!job.isObject())
+		{
+			error = "A job has to be a JSON object";
+			return false;
+		}
+
+		const Json::Value* mode = job.find("mode");
+		if ((mode == nullptr) || !mode->isString() || !ModeFromName(mode->str, options.mode) || (options.mode == SERVE) || (options.mode == BATCH))
+		{
+			error = "Missing or unknown mode";
+			return false;
+		}
+
+		std::vector<std::filesystem::path> inputs;
+		std::vector<std::filesystem::path> outputs;
+		if (!getPathList(job, "inputs", inputs, error) || !getPathList(job, "outputs", outputs, error))
+			return false;
+
+		size_t inputCount = (options.mode == LANG2TXT) ? 2 : 1;
+		size_t outputCount = (options.mode == TXT2LANG) ? 2 : 1;
+		if ((inputs.size() != inputCount) || (outputs.size() != outputCount))
+		{
+			error = std::string(ModeName(options.mode)) + " needs " + std::to_string(inputCount) + " input(s) and " + std::to_string(outputCount) + " output(s)";
+			return false;
+		}
+
+		options.inputFilePath1 = inputs[0];
+		if (inputCount > 1)
+			options.inputFilePath2 = inputs[1];
+		options.outputFilePath1 = outputs[0];
+		if (outputCount > 1)
+			options.outputFilePath2 = outputs[1];
+
+		if (!getBool(job, "utf8", options.useUTF8, error) || !getBool(job, "raw", options.useRAW, error)
+			|| !getBool(job, "bom", options.useBOM, error) || !getBool(job, "tail_merge", options.tailMerge, error)
+			|| !getBool(job, "incremental", options.incremental, error) || !getBool(job, "aliases", options.aliases, error))
+			return false;
+
+		const Json::Value* gzLevel = job.find("gz_level");
+		if (gzLevel != nullptr)
+		{
+			if (gzLevel->isString() && (gzLevel->str == "fast"))
+				options.gzLevel = GZ_FAST;
+			else if (gzLevel->isString() && (gzLevel->str == "best"))
+				options.gzLevel = GZ_BEST;
+			else if (gzLevel->isString() && (gzLevel->str == "default"))
+				options.gzLevel = GZ_DEFAULT;
+			else
+			{
+				error = "'gz_level' has to be \"fast\", \"best\" or \"default\"";
+				return false;
+			}
+		}
+
+		const Json::Value* jobs = job.find("jobs");
+		if (jobs != nullptr)
+		{
+			if (!jobs->isNumber() || (jobs->number < 0) || (jobs->number > 4096) || (std::floor(jobs->number) != jobs->number))
+			{
+				error = "'jobs' has to be a whole number between 0 and 4096";
+				return false;
+			}
+
+			options.jobs = (unsigned int)jobs->number;
+		}
+
+		return true;
+	}
+
+	std::string JobIdJson(const Json::Value& job)
+	{
+		const Json::Value* id = job.isObject() ? job.find("id") : nullptr;
+		if (id == nullptr)
+			return "null";
+
+		std::string out;
+		if (id->isString())
+		{
+			Json::appendString(out, id->str);
+		}
+		else if (id->isNumber())
+		{
+			char buf[32];
+			if ((std::floor(id->number) == id->number) && (std::fabs(id->number) < 1e15))
+				snprintf(buf, sizeof(buf), "%lld", (long long)id->number);
+			else
+				snprintf(buf, sizeof(buf), "%.17g", id->number);
+			out = buf;
+		}
+		else if (id->isBool())
+		{
+			out = id->boolean ? "true" : "false";
+		}
+		else
+		{
+			out = "null";
+		}
+
+		return out;
+	}
+
+	JobResult RunCaptured(const Options& options)
+	{
+		JobResult result;
+		BufferedConsole console;
+
+		auto start = std::chrono::steady_clock::now();
+		try
+		{
+			result.code = RunOptions(options);
+		}
+		catch (const std::exception& e)
+		{
+			ConErr() << "ERROR: " << e.what() << '\n';
+			result.code = -1;
+		}
+		result.runMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		result.out = console.takeOut();
+		result.err = console.takeErr();
+		return result;
+	}
+
+	//
+	// Where the results of one client go. Keeps count of its jobs still running, so the client can be let go once they're done.
+	//
+	struct ResultStream
+	{
+		std::mutex mtx;
+		std::condition_variable cvIdle;
+		size_t pending = 0;
+		std::function<void(const std::string&)> write;
+
+		void begin()
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			pending++;
+		}
+
+		void finish(const std::string& record)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			write(record);
+			pending--;
+			if (pending == 0)
+				cvIdle.notify_all();
+		}
+
+		void waitIdle()
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			cvIdle.wait(lock, [this] { return pending == 0; });
+		}
+	};
+
+	//
+	// Parses one line of input and queues its job. Bad lines get an "invalid" result right away.
+	//
+	static void DispatchLine(std::string_view line, WorkStealingPool& pool, std::shared_ptr<ResultStream> stream)
+	{
+		while (!line.empty() && ((line.back() == '\r') || (line.back() == ' ') || (line.back() == '\t')))
+			line.remove_suffix(1);
+		if (line.find_first_not_of(" \t") == std::string_view::npos)
+			return;
+
+		auto received = std::chrono::steady_clock::now();
+
+		Json::Parser parser;
+		Json::Value job;
+		Options options;
+		std::string error;
+
+		bool bValid = parser.parse(line, job);
+		if (!bValid)
+			error = "Invalid JSON: " + parser.lastError();
+		else
+			bValid = OptionsFromJson(job, options, error);
+
+		std::string id = JobIdJson(job);
+
+		stream->begin();
+		if (!bValid)
+		{
+			stream->finish(Json::Object().addRaw("id", id).add("status", "invalid").add("code", 1).add("error", error).str());
+			return;
+		}
+
+		pool.submit([stream, options, id, received]()
+		{
+			double queueMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - received).count();
+			JobResult result = RunCaptured(options);
+
+			stream->finish(Json::Object()
+				.addRaw("id", id)
+				.add("mode", ModeName(options.mode))
+				.add("status", (result.code == 0) ? "ok" : "failed")
+				.add("code", result.code)
+				.add("queue_ms", queueMs)
+				.add("run_ms", result.runMs)
+				.add("stdout", result.out)
+				.add("stderr", result.err)
+				.str());
+		});
+	}
+
+#ifndef _WIN32
+	//
+	// Serves one socket client until it hangs up and all of its jobs are answered
+	//
+	static void ServeConnection(int fd, WorkStealingPool& pool)
+	{
+		auto stream = std::make_shared<ResultStream>();
+		stream->write = [fd](const std::string& record)
+		{
+			std::string line = record + '\n';
+			const char* p = line.data();
+			size_t left = line.size();
+			while (left)
+			{
+				ssize_t sent = send(fd, p, left, 0);
+				if (sent < 0)
+				{
+					if (errno == EINTR)
+						continue;
+
+					// the client is gone, the rest of its results go nowhere
+					return;
+				}
+
+				p += sent;
+				left -= sent;
+			}
+		};
+
+		std::string buffer;
+		std::vector<char> chunk(64 * 1024);
+		while (true)
+		{
+			ssize_t received = recv(fd, chunk.data(), chunk.size(), 0);
+			if ((received < 0) && (errno == EINTR))
+				continue;
+			if (received <= 0)
+				break;
+
+			buffer.append(chunk.data(), received);
+
+			size_t start = 0;
+			size_t newline;
+			while ((newline = buffer.find('\n', start)) != std::string::npos)
+			{
+				DispatchLine(std::string_view(buffer).substr(start, newline - start), pool, stream);
+				start = newline + 1;
+			}
+			buffer.erase(0, start);
+		}
+
+		if (!buffer.empty())
+			DispatchLine(buffer, pool, stream);
+
+		stream->waitIdle();
+		close(fd);
+	}
+
+	static int ServeSocket(const std::filesystem::path& socketPath, WorkStealingPool& pool)
+	{
+		// results to clients that hung up shouldn't kill the server
+		signal(SIGPIPE, SIG_IGN);
+
+		std::string pathStr = socketPath.string();
+		sockaddr_un addr = {};
+		addr.sun_family = AF_UNIX;
+		if (pathStr.size() >= sizeof(addr.sun_path))
+		{
+			std::cerr << "ERROR: Socket path is too long: " << pathStr << '\n';
+			return -1;
+		}
+		memcpy(addr.sun_path, pathStr.c_str(), pathStr.size() + 1);
+
+		int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listenFd < 0)
+		{
+			std::cerr << "ERROR: Can't create a socket.\n";
+			std::cerr << "Reason: " << strerror(errno) << '\n';
+			return -1;
+		}
+
+		// a socket left behind by an earlier run would make bind fail
+		struct stat st;
+		if ((stat(pathStr.c_str(), &st) == 0) && S_ISSOCK(st.st_mode))
+			unlink(pathStr.c_str());
+
+		if ((bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0) || (listen(listenFd, SOMAXCONN) < 0))
+		{
+			std::cerr << "ERROR: Can't listen on: " << pathStr << '\n';
+			std::cerr << "Reason: " << strerror(errno) << '\n';
+			close(listenFd);
+			return -1;
+		}
+
+		std::cerr << "Listening on: " << pathStr << '\n';
+
+		std::mutex mtxClients;
+		std::condition_variable cvClients;
+		size_t clientCount = 0;
+
+		while (true)
+		{
+			int fd = accept(listenFd, nullptr, nullptr);
+			if (fd < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				std::cerr << "ERROR: Can't accept connections anymore.\n";
+				std::cerr << "Reason: " << strerror(errno) << '\n';
+				break;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mtxClients);
+				clientCount++;
+			}
+
+			std::thread([fd, &pool, &mtxClients, &cvClients, &clientCount]()
+			{
+				ServeConnection(fd, pool);
+
+				std::lock_guard<std::mutex> lock(mtxClients);
+				clientCount--;
+				cvClients.notify_all();
+			}).detach();
+		}
+
+		close(listenFd);
+		unlink(pathStr.c_str());
+
+		// the clients still use the pool
+		std::unique_lock<std::mutex> lock(mtxClients);
+		cvClients.wait(lock, [&clientCount] { return clientCount == 0; });
+
+		return -1;
+	}
+#endif
+
+	int Serve(unsigned int nWorkers, const std::filesystem::path& socketPath)
+	{
+		WorkStealingPool pool(WorkStealingPool::resolveThreadCount(nWorkers));
+
+		if (!socketPath.empty())
+		{
+#ifdef _WIN32
+			std::cerr << "ERROR: --socket isn't supported on Windows, send the jobs on stdin instead!\n";
+			return 1;
+#else
+			return ServeSocket(socketPath, pool);
+#endif
+		}
+
+		auto stream = std::make_shared<ResultStream>();
+		stream->write = [](const std::string& record)
+		{
+			std::cout << record << '\n';
+			std::cout.flush();
+		};
+
+		std::string line;
+		while (std::getline(std::cin, line))
+			DispatchLine(line, pool, stream);
+
+		stream->waitIdle();
+		return 0;
+	}
+	enum BatchJobState
+	{
+		JOB_PENDING,
+		JOB_OK,
+		JOB_FAILED,
+		JOB_SKIPPED,
+		JOB_INVALID,
+		JOB_DUPLICATE
+	};
+
+	struct BatchJob
+	{
+		std::string id;             // for the table, strings without quotes
+		const char* mode = "-";
+		Options options;
+		std::string error;
+		BatchJobState state = JOB_PENDING;
+		int code = 0;
+		double runMs = 0.0;
+		size_t duplicateOf = SIZE_MAX;
+		size_t unmetDeps = 0;
+		bool bDepFailed = false;
+		std::vector<size_t> dependents;
+	};
+
+	//
+	// Key for comparing paths of different jobs, so "a/../b.txt" and "b.txt" are the same file
+	//
+	static std::u8string PathKey(const std::filesystem::path& path)
+	{
+		std::error_code ec;
+		std::filesystem::path abs = std::filesystem::absolute(path, ec);
+		if (ec)
+			abs = path;
+
+		return abs.lexically_normal().generic_u8string();
+	}
+
+	static std::vector<std::filesystem::path> JobInputs(const Options& options)
+	{
+		std::vector<std::filesystem::path> paths = { options.inputFilePath1 };
+		if (options.mode == LANG2TXT)
+			paths.push_back(options.inputFilePath2);
+		return paths;
+	}
+
+	static std::vector<std::filesystem::path> JobOutputs(const Options& options)
+	{
+		std::vector<std::filesystem::path> paths = { options.outputFilePath1 };
+		if (options.mode == TXT2LANG)
+			paths.push_back(options.outputFilePath2);
+		return paths;
+	}
+
+	//
+	// Everything that changes what a job writes. The job count doesn't, so it's left out.
+	//
+	static std::u8string JobKey(const Options& options)
+	{
+		std::string flags = std::string(ModeName(options.mode)) + (options.useUTF8 ? "|u" : "|") + (options.useRAW ? "r" : "")
+			+ (options.useBOM ? "b" : "") + (options.tailMerge ? "t" : "") + (options.aliases ? "a" : "") + std::to_string((int)options.gzLevel);
+
+		std::u8string key(flags.begin(), flags.end());
+		for (const auto& path : JobInputs(options))
+			key += u8"|<" + PathKey(path);
+		for (const auto& path : JobOutputs(options))
+			key += u8"|>" + PathKey(path);
+		return key;
+	}
+
+	static void LoadManifestJob(const Json::Value& value, const std::filesystem::path& baseFolder, BatchJob& job)
+	{
+		const Json::Value* id = value.isObject() ? value.find("id") : nullptr;
+		if ((id != nullptr) && id->isString())
+			job.id = id->str;
+		else if ((id != nullptr) && !id->isNull())
+			job.id = JobIdJson(value);
+
+		if (!OptionsFromJson(value, job.options, job.error))
+		{
+			job.state = JOB_INVALID;
+			return;
+		}
+
+		job.mode = ModeName(job.options.mode);
+
+		for (auto* path : { &job.options.inputFilePath1, &job.options.inputFilePath2, &job.options.outputFilePath1, &job.options.outputFilePath2 })
+		{
+			if (!path->empty() && path->is_relative())
+				*path = baseFolder / *path;
+		}
+	}
+
+	static bool LoadManifest(const std::filesystem::path& manifestPath, std::vector<BatchJob>& jobs)
+	{
+		FileBuffer manifest;
+		try
+		{
+			manifest.openFile(manifestPath);
+		}
+		catch (const std::exception& e)
+		{
+			ConErr() << "ERROR: Failed to open file: " << manifestPath.string() << " for reading.\n";
+			ConErr() << "Reason: " << e.what() << '\n';
+			return false;
+		}
+
+		std::string_view text((const char*)manifest.data(), manifest.size());
+		if (GetBOM(manifest.data(), manifest.size()) == UnicodeBOMType::BOM_UTF8)
+			text.remove_prefix(3);
+
+		std::filesystem::path baseFolder = manifestPath.parent_path();
+		Json::Parser parser;
+		Json::Value value;
+
+		size_t first = text.find_first_not_of(" \t\r\n");
+		if ((first != std::string_view::npos) && (text[first] == '['))
+		{
+			if (!parser.parse(text, value))
+			{
+				ConErr() << "ERROR: Invalid manifest: " << manifestPath.string() << '\n';
+				ConErr() << "Reason: " << parser.lastError() << '\n';
+				return false;
+			}
+
+			jobs.resize(value.items.size());
+			for (size_t i = 0; i < value.items.size(); i++)
+				LoadManifestJob(value.items[i], baseFolder, jobs[i]);
+
+			return true;
+		}
+
+		// one job per line
+		while (!text.empty())
+		{
+			size_t newline = text.find('\n');
+			std::string_view line = text.substr(0, newline);
+			text.remove_prefix((newline == std::string_view::npos) ? text.size() : (newline + 1));
+
+			if (line.find_first_not_of(" \t\r") == std::string_view::npos)
+				continue;
+
+			BatchJob& job = jobs.emplace_back();
+			if (parser.parse(line, value))
+			{
+				LoadManifestJob(value, baseFolder, job);
+			}
+			else
+			{
+				job.state = JOB_INVALID;
+				job.error = "Invalid JSON: " + parser.lastError();
+			}
+		}
+
+		return true;
+	}
+
+	//
+	// Collapses identical jobs and links every job to the jobs writing its inputs
+	//
+	static void PlanBatch(std::vector<BatchJob>& jobs)
+	{
+		std::unordered_map<std::u8string, size_t> jobByKey;
+		std::unordered_map<std::u8string, size_t> writerByPath;
+
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			BatchJob& job = jobs[i];
+			if (job.state != JOB_PENDING)
+				continue;
+
+			auto [itJob, bNewJob] = jobByKey.try_emplace(JobKey(job.options), i);
+			if (!bNewJob)
+			{
+				job.state = JOB_DUPLICATE;
+				job.duplicateOf = itJob->second;
+				continue;
+			}
+
+			for (const auto& path : JobOutputs(job.options))
+			{
+				auto [itWriter, bNewPath] = writerByPath.try_emplace(PathKey(path), i);
+				if (!bNewPath)
+				{
+					job.state = JOB_INVALID;
+					job.error = "Writes " + path.string() + ", same as job #" + std::to_string(itWriter->second + 1);
+					break;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			BatchJob& job = jobs[i];
+			if (job.state != JOB_PENDING)
+				continue;
+
+			for (const auto& path : JobInputs(job.options))
+			{
+				auto itWriter = writerByPath.find(PathKey(path));
+				if ((itWriter == writerByPath.end()) || (itWriter->second == i) || (jobs[itWriter->second].state != JOB_PENDING))
+					continue;
+
+				jobs[itWriter->second].dependents.push_back(i);
+				job.unmetDeps++;
+			}
+		}
+	}
+
+	static void PrintBatchTable(const std::vector<BatchJob>& jobs)
+	{
+		static const char* stateNames[] = { "pending", "ok", "failed", "skipped", "invalid", "duplicate" };
+
+		size_t idWidth = 2;
+		for (const BatchJob& job : jobs)
+			idWidth = std::max(idWidth, std::min<size_t>(job.id.size(), 32));
+
+		char line[256];
+		snprintf(line, sizeof(line), "\n%5s  %-*s  %-9s  %-9s  %5s  %10s  %s\n", "#", (int)idWidth, "ID", "MODE", "STATUS", "CODE", "TIME (ms)", "NOTE");
+		ConOut() << line;
+
+		size_t counts[6] = {};
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			const BatchJob& job = jobs[i];
+			counts[job.state]++;
+
+			std::string note = job.error;
+			if ((job.state == JOB_DUPLICATE) && note.empty())
+				note = "same as job #" + std::to_string(job.duplicateOf + 1);
+
+			std::string id = job.id.substr(0, 32);
+			bool bRan = (job.state == JOB_OK) || (job.state == JOB_FAILED);
+
+			snprintf(line, sizeof(line), "%5zu  %-*s  %-9s  %-9s  ", i + 1, (int)idWidth, id.c_str(), job.mode, stateNames[job.state]);
+			ConOut() << line;
+			if (bRan)
+				snprintf(line, sizeof(line), "%5d  %10.3f  ", job.code, job.runMs);
+			else
+				snprintf(line, sizeof(line), "%5s  %10s  ", "-", "-");
+			ConOut() << line << note << '\n';
+		}
+
+		ConOut() << '\n' << jobs.size() << " job(s): " << counts[JOB_OK] << " ok, " << counts[JOB_FAILED] << " failed, " << counts[JOB_SKIPPED] << " skipped, "
+			<< counts[JOB_INVALID] << " invalid, " << counts[JOB_DUPLICATE] << " duplicate\n";
+	}
+
+	int RunBatch(const std::filesystem::path& manifestPath, unsigned int nWorkers)
+	{
+		std::vector<BatchJob> jobs;
+		if (!LoadManifest(manifestPath, jobs))
+			return -1;
+
+		PlanBatch(jobs);
+
+		WorkStealingPool pool(WorkStealingPool::resolveThreadCount(nWorkers));
+		OrderedReporter reporter(jobs.size());
+		std::mutex mtxJobs;
+
+		std::function<void(size_t)> runJob;
+		auto finishJob = [&](size_t index, JobResult result)
+		{
+			std::vector<size_t> ready;
+			std::vector<size_t> skipped;
+			{
+				std::lock_guard<std::mutex> lock(mtxJobs);
+				BatchJob& job = jobs[index];
+				job.code = result.code;
+				job.runMs = result.runMs;
+				job.state = (result.code == 0) ? JOB_OK : JOB_FAILED;
+
+				// wake up the dependents, a failure is passed down the whole chain
+				std::vector<std::pair<size_t, bool>> finished = { { index, job.state == JOB_OK } };
+				while (!finished.empty())
+				{
+					auto [done, bOk] = finished.back();
+					finished.pop_back();
+
+					for (size_t dep : jobs[done].dependents)
+					{
+						BatchJob& dependent = jobs[dep];
+						dependent.bDepFailed |= !bOk;
+						if (--dependent.unmetDeps != 0)
+							continue;
+
+						if (dependent.bDepFailed)
+						{
+							dependent.state = JOB_SKIPPED;
+							dependent.error = "An input comes from a job that didn't succeed";
+							skipped.push_back(dep);
+							finished.push_back({ dep, false });
+						}
+						else
+						{
+							ready.push_back(dep);
+						}
+					}
+				}
+			}
+
+			reporter.report(index, std::move(result.out), std::move(result.err));
+			for (size_t dep : skipped)
+				reporter.report(dep, std::string(), std::string());
+			for (size_t dep : ready)
+				pool.submit([&runJob, dep] { runJob(dep); });
+		};
+
+		runJob = [&](size_t index)
+		{
+			finishJob(index, RunCaptured(jobs[index].options));
+		};
+
+		// everything not waiting on another job can start right away
+		std::vector<size_t> initial;
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			BatchJob& job = jobs[i];
+			if (job.state == JOB_INVALID)
+				reporter.report(i, std::string(), "ERROR: Job #" + std::to_string(i + 1) + ": " + job.error + '\n');
+			else if (job.state == JOB_DUPLICATE)
+				reporter.report(i, std::string(), std::string());
+			else if (job.unmetDeps == 0)
+				initial.push_back(i);
+		}
+
+		for (size_t index : initial)
+			pool.submit([&runJob, index] { runJob(index); });
+		pool.wait();
+
+		// jobs that read each other's output never got to run
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			BatchJob& job = jobs[i];
+			if (job.state == JOB_PENDING)
+			{
+				job.state = JOB_SKIPPED;
+				job.error = "Its inputs and outputs form a cycle with other jobs";
+				reporter.report(i, std::string(), std::string());
+			}
+		}
+
+		// duplicates share the result of the job they copy
+		int exitCode = 0;
+		for (BatchJob& job : jobs)
+		{
+			if ((job.state == JOB_DUPLICATE) && (jobs[job.duplicateOf].state != JOB_OK))
+				job.error = "same as job #" + std::to_string(job.duplicateOf + 1) + ", which didn't succeed";
+
+			if ((job.state != JOB_OK) && ((job.state != JOB_DUPLICATE) || !job.error.empty()))
+				exitCode = 1;
+		}
+
+		PrintBatchTable(jobs);
+		return exitCode;
+	}
+}
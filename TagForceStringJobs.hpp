@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <filesystem>
+#include "TagForceStringCli.hpp"
+#include "Json.hpp"
+
+#ifndef TFSTRINGJOBS_HDR
+#define TFSTRINGJOBS_HDR
+
+//
+// Conversion jobs described in JSON, and the serve mode that runs them.
+//
+// A job is one JSON object, e.g.:
+//   {"id": 1, "mode": "lang2txt", "inputs": ["langIe.bin", "langLe.bin"], "outputs": ["lang_e.txt"], "utf8": false}
+// Members: id (echoed back), mode, inputs, outputs (arrays or a single string), utf8, raw, bom, tail_merge, gz_level ("fast" / "best"), incremental, jobs.
+//
+namespace TagForceString
+{
+	struct JobResult
+	{
+		int code = 0;           // Same as the tool's exit code, 0 = success
+		double runMs = 0.0;
+		std::string out;        // Captured console output
+		std::string err;
+	};
+
+	//
+	// Fills options from a JSON job. Returns false and sets error if the job isn't valid.
+	//
+	bool OptionsFromJson(const Json::Value& job, Options& options, std::string& error);
+
+	//
+	// Formats the id member of a job for echoing it back ("null" if there is none)
+	//
+	std::string JobIdJson(const Json::Value& job);
+
+	//
+	// Runs a conversion on the current thread with its console output captured
+	//
+	JobResult RunCaptured(const Options& options);
+
+	//
+	// Reads jobs as JSON lines (stdin, or connections to a Unix socket if socketPath isn't empty),
+	// runs them on nWorkers threads (0 = all hardware threads) and writes one JSON result line per job.
+	// Results are written as jobs finish, so they can come back in a different order; the id tells them apart.
+	//
+	int Serve(unsigned int nWorkers, const std::filesystem::path& socketPath);
+
+	//
+	// Runs the jobs of a manifest file: a JSON array of jobs, or one job per line. Relative paths are relative to the manifest.
+	// Identical jobs run once, and a job that reads what another job writes waits for it (and is skipped if it failed).
+	// Prints the output of every job in manifest order and then a status table. Returns 0 if all jobs succeeded.
+	//
+	int RunBatch(const std::filesystem::path& manifestPath, unsigned int nWorkers);
+}
+
+#endif
@@ -0,0 +1,308 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include "TagForceString.hpp"
+#include "Stats.hpp"
+
+namespace TagForceString
+{
+	thread_local std::ostream* pConOut = &std::cout;
+	thread_local std::ostream* pConErr = &std::cerr;
+
+	std::ostream& ConOut()
+	{
+		return *pConOut;
+	}
+
+	std::ostream& ConErr()
+	{
+		return *pConErr;
+	}
+
+	std::ostream* SetConOut(std::ostream* out)
+	{
+		std::ostream* old = pConOut;
+		pConOut = out;
+		return old;
+	}
+
+	std::ostream* SetConErr(std::ostream* err)
+	{
+		std::ostream* old = pConErr;
+		pConErr = err;
+		return old;
+	}
+
+	UnicodeBOMType GetBOM(std::ifstream& file)
+	{
+		std::streampos oldpos = file.tellg();
+
+		uint8_t bomchk1 = file.get();
+		uint8_t bomchk2 = file.get();
+		uint8_t bomchk3 = file.get();
+
+		file.seekg(oldpos, std::ios::beg);
+
+		if ((bomchk1 == 0xEF) && (bomchk2 == 0xBB) && (bomchk3 == 0xBF))
+			return UnicodeBOMType::BOM_UTF8;
+
+		uint16_t bomchk = (uint16_t)(bomchk2 << 8) | bomchk1;
+		if (bomchk == 0xFFFE)
+			return UnicodeBOMType::BOM_UTF16BE;
+
+		if (bomchk == 0xFEFF)
+			return UnicodeBOMType::BOM_UTF16LE;
+
+		return UnicodeBOMType::BOM_UNKNOWN;
+	}
+
+	UnicodeBOMType GetBOM(std::filesystem::path filename)
+	{
+		std::ifstream file;
+		try
+		{
+			file.open(filename, std::ios::binary);
+			if (!file.is_open())
+			{
+				throw std::runtime_error(strerror(errno));
+			}
+		}
+		catch (const std::exception& e)
+		{
+			throw e;
+		}
+
+		UnicodeBOMType result = GetBOM(file);
+
+		file.close();
+
+		return result;
+	}
+
+	UnicodeBOMType GetBOM(const uint8_t* data, uintmax_t size)
+	{
+		if ((size >= 3) && (data[0] == 0xEF) && (data[1] == 0xBB) && (data[2] == 0xBF))
+			return UnicodeBOMType::BOM_UTF8;
+
+		if (size < 2)
+			return UnicodeBOMType::BOM_UNKNOWN;
+
+		uint16_t bomchk = (uint16_t)(data[1] << 8) | data[0];
+		if (bomchk == 0xFFFE)
+			return UnicodeBOMType::BOM_UTF16BE;
+
+		if (bomchk == 0xFEFF)
+			return UnicodeBOMType::BOM_UTF16LE;
+
+		return UnicodeBOMType::BOM_UNKNOWN;
+	}
+
+	void removeCRLF(std::u16string& str)
+	{
+		if (!str.empty())
+		{
+			if (str.back() == u'\n')
+			{
+				str.pop_back();
+			}
+
+			if (!str.empty() && str.back() == u'\r')
+			{
+				str.pop_back();
+			}
+		}
+	}
+
+	void removeCRLF(std::u8string& str)
+	{
+		if (!str.empty())
+		{
+			if (str.back() == u8'\n')
+			{
+				str.pop_back();
+			}
+
+			if (!str.empty() && str.back() == u8'\r')
+			{
+				str.pop_back();
+			}
+		}
+	}
+
+	void removeCRLF(std::string& str)
+	{
+		if (!str.empty())
+		{
+			if (str.back() == '\n')
+			{
+				str.pop_back();
+			}
+
+			if (!str.empty() && str.back() == '\r')
+			{
+				str.pop_back();
+			}
+		}
+	}
+
+	bool isStrNumeric(const std::string& str)
+	{
+		for (char ch : str)
+		{
+			if (ch >= -1 && ch <= 255)
+			{
+				if (!std::isdigit(ch))
+				{
+					return false;
+				}
+			}
+			else
+				return false;
+		}
+		return true;
+	}
+
+	int ParseTxtU16(const uint8_t* txtData, uintmax_t txtSize, std::vector<std::u16string>* outStrings, std::vector<uint32_t>* outAliases)
+	{
+		Stats::Scope scope(Stats::STAGE_PARSE);
+		scope.addBytes(txtSize);
+
+		// check BOM and skip if valid...
+		UnicodeBOMType bt = GetBOM(txtData, txtSize);
+		if (bt == UnicodeBOMType::BOM_UTF16BE)
+		{
+			ConErr() << "Big endian BOM detected! Please only use little endian files!\n";
+			return -2;
+		}
+
+		uintmax_t start = 0;
+		if (bt == UnicodeBOMType::BOM_UTF16LE)
+			start = 2;
+		else
+			ConOut() << "WARNING: Unknown or no BOM detected!\n";
+
+		const char16_t* cursor = reinterpret_cast<const char16_t*>(txtData + start);
+		const char16_t* end = cursor + ((txtSize - start) / sizeof(char16_t));
+
+		// collect the sections, then put them in index order
+		std::vector<TxtSection<std::u16string>> sections;
+		parseSections<char16_t, false>(cursor, end, sections);
+
+		copySections(sections, outStrings, outAliases);
+		Stats::Add(Stats::COUNTER_STRINGS_PARSED, outStrings->size());
+		return 0;
+	}
+
+	int ParseTxtU16(std::filesystem::path txtFilename, std::vector<std::u16string>* outStrings, std::vector<uint32_t>* outAliases)
+	{
+		FileBuffer txtfile;
+		try
+		{
+			Stats::Scope scope(Stats::STAGE_OPEN);
+			txtfile.openFile(txtFilename);
+			scope.addBytes(txtfile.size());
+		}
+		catch (const std::exception& e)
+		{
+			ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for reading.\n";
+			ConErr() << "Reason: " << e.what() << '\n';
+			return -1;
+		}
+
+		return ParseTxtU16(txtfile.data(), txtfile.size(), outStrings, outAliases);
+	}
+
+	int ParseTxtU8(const uint8_t* txtData, uintmax_t txtSize, std::vector<std::u8string>* outStrings, std::vector<uint32_t>* outAliases)
+	{
+		Stats::Scope scope(Stats::STAGE_PARSE);
+		scope.addBytes(txtSize);
+
+		// check BOM and skip if valid...
+		UnicodeBOMType bt = GetBOM(txtData, txtSize);
+		if ((bt == UnicodeBOMType::BOM_UTF16LE) || (bt == UnicodeBOMType::BOM_UTF16BE))
+		{
+			ConErr() << "UTF-16 BOM detected! Please check that you're using a UTF-8 file!\n";
+			return -2;
+		}
+
+		uintmax_t start = 0;
+		if (bt == UnicodeBOMType::BOM_UTF8)
+			start = 3;
+		else
+			ConOut() << "WARNING: Unknown or no BOM detected!\n";
+
+		const char8_t* cursor = reinterpret_cast<const char8_t*>(txtData + start);
+		const char8_t* end = reinterpret_cast<const char8_t*>(txtData + txtSize);
+
+		// collect the sections, then put them in index order
+		std::vector<TxtSection<std::u8string>> sections;
+		parseSections<char8_t, false>(cursor, end, sections);
+
+		copySections(sections, outStrings, outAliases);
+		Stats::Add(Stats::COUNTER_STRINGS_PARSED, outStrings->size());
+		return 0;
+	}
+
+	int ParseTxtU8(std::filesystem::path txtFilename, std::vector<std::u8string>* outStrings, std::vector<uint32_t>* outAliases)
+	{
+		FileBuffer txtfile;
+		try
+		{
+			Stats::Scope scope(Stats::STAGE_OPEN);
+			txtfile.openFile(txtFilename);
+			scope.addBytes(txtfile.size());
+		}
+		catch (const std::exception& e)
+		{
+			ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for reading.\n";
+			ConErr() << "Reason: " << e.what() << '\n';
+			return -1;
+		}
+
+		return ParseTxtU8(txtfile.data(), txtfile.size(), outStrings, outAliases);
+	}
+
+	int ParseTxtRaw(const uint8_t* txtData, uintmax_t txtSize, std::vector<std::string>* outStrings, std::vector<uint32_t>* outAliases)
+	{
+		Stats::Scope scope(Stats::STAGE_PARSE);
+		scope.addBytes(txtSize);
+
+		if ((txtSize == 0) || (txtData[0] != '['))
+		{
+			ConErr() << "ERROR: Invalid file format.\n";
+			return -2;
+		}
+
+		const char* cursor = reinterpret_cast<const char*>(txtData);
+		const char* end = cursor + txtSize;
+
+		// collect the sections, then put them in index order
+		std::vector<TxtSection<std::string>> sections;
+		parseSections<char, true>(cursor, end, sections);
+
+		copySections(sections, outStrings, outAliases);
+		Stats::Add(Stats::COUNTER_STRINGS_PARSED, outStrings->size());
+		return 0;
+	}
+
+	int ParseTxtRaw(std::filesystem::path txtFilename, std::vector<std::string>* outStrings, std::vector<uint32_t>* outAliases)
+	{
+		FileBuffer txtfile;
+		try
+		{
+			Stats::Scope scope(Stats::STAGE_OPEN);
+			txtfile.openFile(txtFilename);
+			scope.addBytes(txtfile.size());
+		}
+		catch (const std::exception& e)
+		{
+			ConErr() << "ERROR: Failed to open file: " << txtFilename.string() << " for reading.\n";
+			ConErr() << "Reason: " << e.what() << '\n';
+			return -1;
+		}
+
+		return ParseTxtRaw(txtfile.data(), txtfile.size(), outStrings, outAliases);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef THREADPOOL_HDR
+#define THREADPOOL_HDR
+
+//
+// A small work-stealing thread pool.
+// Every worker owns a queue and works from its back. When it runs dry, it steals from the front of the others.
+// Jobs submitted from outside of the pool are spread over the queues round-robin.
+// With a single thread, jobs simply run on the caller's thread inside submit().
+//
+class WorkStealingPool
+{
+private:
+	struct WorkQueue
+	{
+		std::mutex mtx;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex mtxState;
+	std::condition_variable cvWork;
+	std::condition_variable cvIdle;
+	size_t queuedCount;
+	size_t pendingCount;
+	bool bStop;
+
+	std::atomic<size_t> nextQueue;
+
+	// which pool (if any) the current thread works for, pools can be nested
+	struct WorkerSlot
+	{
+		const WorkStealingPool* pool = nullptr;
+		int index = -1;
+	};
+
+	static WorkerSlot& currentWorker()
+	{
+		static thread_local WorkerSlot slot;
+		return slot;
+	}
+
+	bool popLocal(size_t index, std::function<void()>& job)
+	{
+		WorkQueue& q = *queues[index];
+		std::lock_guard<std::mutex> lock(q.mtx);
+		if (q.jobs.empty())
+			return false;
+
+		job = std::move(q.jobs.back());
+		q.jobs.pop_back();
+		return true;
+	}
+
+	bool steal(size_t index, std::function<void()>& job)
+	{
+		for (size_t i = 1; i < queues.size(); i++)
+		{
+			WorkQueue& q = *queues[(index + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(q.mtx);
+			if (q.jobs.empty())
+				continue;
+
+			job = std::move(q.jobs.front());
+			q.jobs.pop_front();
+			return true;
+		}
+
+		return false;
+	}
+
+	void workerLoop(size_t index)
+	{
+		currentWorker().pool = this;
+		currentWorker().index = static_cast<int>(index);
+
+		while (true)
+		{
+			std::function<void()> job;
+			if (popLocal(index, job) || steal(index, job))
+			{
+				{
+					std::lock_guard<std::mutex> lock(mtxState);
+					queuedCount--;
+				}
+
+				job();
+
+				std::lock_guard<std::mutex> lock(mtxState);
+				pendingCount--;
+				if (pendingCount == 0)
+					cvIdle.notify_all();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mtxState);
+			cvWork.wait(lock, [this] { return bStop || (queuedCount > 0); });
+			if (bStop && (queuedCount == 0))
+				return;
+		}
+	}
+
+public:
+	//
+	// Number of threads to use for a requested job count (0 = one per hardware thread)
+	//
+	static unsigned int resolveThreadCount(unsigned int requested)
+	{
+		if (requested)
+			return requested;
+
+		unsigned int hw = std::thread::hardware_concurrency();
+		return hw ? hw : 1;
+	}
+
+	explicit WorkStealingPool(unsigned int threadCount)
+	{
+		queuedCount = 0;
+		pendingCount = 0;
+		bStop = false;
+		nextQueue = 0;
+
+		if (threadCount <= 1)
+			return;
+
+		for (unsigned int i = 0; i < threadCount; i++)
+			queues.push_back(std::make_unique<WorkQueue>());
+
+		for (unsigned int i = 0; i < threadCount; i++)
+			workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+	}
+
+	unsigned int threadCount()
+	{
+		return workers.empty() ? 1 : static_cast<unsigned int>(workers.size());
+	}
+
+	void submit(std::function<void()> job)
+	{
+		if (workers.empty())
+		{
+			job();
+			return;
+		}
+
+		// jobs spawned by a worker stay on its own queue
+		const WorkerSlot& self = currentWorker();
+		size_t index = (self.pool == this) ? static_cast<size_t>(self.index) : (nextQueue++ % queues.size());
+
+		{
+			std::lock_guard<std::mutex> lock(mtxState);
+			queuedCount++;
+			pendingCount++;
+		}
+
+		{
+			WorkQueue& q = *queues[index];
+			std::lock_guard<std::mutex> lock(q.mtx);
+			q.jobs.push_back(std::move(job));
+		}
+
+		cvWork.notify_one();
+	}
+
+	//
+	// Blocks until every submitted job has finished
+	//
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(mtxState);
+		cvIdle.wait(lock, [this] { return pendingCount == 0; });
+	}
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	~WorkStealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtxState);
+			bStop = true;
+		}
+		cvWork.notify_all();
+
+		for (auto& t : workers)
+			t.join();
+	}
+};
+
+#endif
@@ -0,0 +1,218 @@
+#pragma once
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include "TagForceString.hpp"
+#include "Stats.hpp"
+
+#ifndef TXTWRITER_HDR
+#define TXTWRITER_HDR
+
+//
+// Formats an ini-like txt file in memory and writes it out in one go.
+// Documents larger than the flush threshold are written out in pieces of roughly that size instead.
+//
+template<typename CharT>
+class TxtWriter
+{
+public:
+	static constexpr size_t DEFAULT_FLUSH_THRESHOLD = 64 * 1024 * 1024;
+
+private:
+	struct EntryMark
+	{
+		size_t start;   // in code units from the start of the document
+		size_t length;
+	};
+
+	std::ofstream ofile;
+	std::basic_string<CharT> buffer;
+	size_t flushThreshold;
+	size_t flushedUnits;                // already written out
+	std::vector<EntryMark> entryMarks;  // where the escaped string of every entry went
+	bool bFailed;
+
+	void writeOut()
+	{
+		if (buffer.empty())
+			return;
+
+		Stats::Scope scope(Stats::STAGE_WRITE);
+		scope.addBytes(buffer.size() * sizeof(CharT));
+		ofile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(CharT));
+		if (!ofile)
+			bFailed = true;
+
+		flushedUnits += buffer.size();
+		buffer.clear();
+	}
+
+	void checkFlush()
+	{
+		if (flushThreshold && ((buffer.size() * sizeof(CharT)) >= flushThreshold))
+			writeOut();
+	}
+
+	void putNumber(int value)
+	{
+		char digits[16];
+		char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+
+		for (char* p = digits; p < end; p++)
+			buffer.push_back(static_cast<CharT>(*p));
+	}
+
+public:
+	//
+	// Opens the output file, throws on failure
+	//
+	void open(std::filesystem::path filename)
+	{
+		Stats::Scope scope(Stats::STAGE_WRITE);
+		ofile.open(filename, std::ios::out | std::ios::binary);
+		if (!ofile.is_open())
+		{
+			throw std::runtime_error(strerror(errno));
+		}
+	}
+
+	//
+	// Reserves room for the expected document size (in code units)
+	//
+	void reserve(size_t units)
+	{
+		if (flushThreshold)
+			units = std::min(units, flushThreshold / sizeof(CharT) + 1);
+		buffer.reserve(units);
+	}
+
+	//
+	// Writes the BOM matching the code unit size (UTF-8 / UTF-16 LE)
+	//
+	void putBOM()
+	{
+		if constexpr (sizeof(CharT) == sizeof(char16_t))
+		{
+			buffer.push_back(static_cast<CharT>(0xFEFF));
+		}
+		else
+		{
+			buffer.push_back(static_cast<CharT>(0xEF));
+			buffer.push_back(static_cast<CharT>(0xBB));
+			buffer.push_back(static_cast<CharT>(0xBF));
+		}
+	}
+
+	//
+	// Writes a section header, e.g. "[12]\n"
+	//
+	void section(int index)
+	{
+		buffer.push_back(static_cast<CharT>('['));
+		putNumber(index);
+		buffer.push_back(static_cast<CharT>(']'));
+		buffer.push_back(static_cast<CharT>('\n'));
+	}
+
+	//
+	// Writes the header of a section that shares the string of an earlier one, e.g. "[12]=@5\n". It has no text of its own.
+	//
+	void aliasSection(int index, int target)
+	{
+		buffer.push_back(static_cast<CharT>('['));
+		putNumber(index);
+		buffer.push_back(static_cast<CharT>(']'));
+		buffer.push_back(static_cast<CharT>('='));
+		buffer.push_back(static_cast<CharT>('@'));
+		putNumber(target);
+		buffer.push_back(static_cast<CharT>('\n'));
+	}
+
+	void put(CharT ch)
+	{
+		buffer.push_back(ch);
+	}
+
+	void append(const CharT* data, size_t len)
+	{
+		buffer.append(data, len);
+		checkFlush();
+	}
+
+	void append(const std::basic_string<CharT>& str)
+	{
+		append(str.data(), str.size());
+	}
+
+	//
+	// Appends a string with '\\' and '[' escaped, growing the buffer by the exact escaped size
+	//
+	void appendEscaped(const CharT* data, size_t len)
+	{
+		size_t pos = buffer.size();
+		buffer.resize(pos + TagForceString::escapedLength(data, len));
+		TagForceString::escapeInto(data, len, buffer.data() + pos);
+		checkFlush();
+	}
+
+	//
+	// Makes room to track the escaped strings of a resource's entries for appendEscapedEntry()
+	//
+	void reserveEntries(size_t count)
+	{
+		entryMarks.assign(count, EntryMark{ 0, 0 });
+	}
+
+	//
+	// Appends the escaped string of a resource entry. An entry sharing its string with an earlier one (first, from the side index)
+	// copies that entry's escaped text while it's still in the buffer, instead of escaping it again.
+	//
+	void appendEscapedEntry(size_t entry, size_t first, const CharT* data, size_t len)
+	{
+		size_t pos = buffer.size();
+		if (first != entry)
+		{
+			const EntryMark mark = entryMarks[first];
+			if (mark.start >= flushedUnits)
+			{
+				buffer.resize(pos + mark.length);
+				std::copy_n(buffer.data() + (mark.start - flushedUnits), mark.length, buffer.data() + pos);
+				checkFlush();
+				return;
+			}
+		}
+
+		size_t escapedLength = TagForceString::escapedLength(data, len);
+		buffer.resize(pos + escapedLength);
+		TagForceString::escapeInto(data, len, buffer.data() + pos);
+		entryMarks[entry] = EntryMark{ flushedUnits + pos, escapedLength };
+		checkFlush();
+	}
+
+	//
+	// Writes out whatever is left and closes the file. Returns false if any write failed.
+	//
+	bool close()
+	{
+		writeOut();
+
+		Stats::Scope scope(Stats::STAGE_WRITE);
+		ofile.close();
+		return !bFailed && !ofile.fail();
+	}
+
+	explicit TxtWriter(size_t threshold = DEFAULT_FLUSH_THRESHOLD)
+	{
+		flushThreshold = threshold;
+		flushedUnits = 0;
+		bFailed = false;
+	}
+};
+
+#endif
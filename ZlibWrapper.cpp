@@ -0,0 +1,179 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+
+#include "ZlibWrapper.hpp"
+
+namespace ZLibWrapper
+{
+    uintmax_t getInflatedSizeHint(const uint8_t* gzData, uintmax_t gzSize)
+    {
+        // 10 byte header + empty deflate block + 8 byte trailer
+        if (gzSize < 20)
+            return 0;
+
+        const uint8_t* trailer = gzData + gzSize - 4;
+        uintmax_t isize = (uintmax_t)trailer[0] | ((uintmax_t)trailer[1] << 8) | ((uintmax_t)trailer[2] << 16) | ((uintmax_t)trailer[3] << 24);
+
+        // deflate can't do better than ~1032:1, anything above that is a broken or hostile file
+        return std::min(isize, gzSize * 1032);
+    }
+
+    uintmax_t getInflatedSizeHint(std::filesystem::path gzFilePath)
+    {
+        std::error_code ec;
+        uintmax_t gzSize = std::filesystem::file_size(gzFilePath, ec);
+
+        // 10 byte header + empty deflate block + 8 byte trailer
+        if (ec || (gzSize < 20))
+            return 0;
+
+        std::ifstream ifile(gzFilePath, std::ios::binary);
+        if (!ifile.is_open())
+            return 0;
+
+        uint8_t trailer[4];
+        ifile.seekg(-4, std::ios::end);
+        if (!ifile.read((char*)trailer, sizeof(trailer)))
+            return 0;
+
+        uintmax_t isize = (uintmax_t)trailer[0] | ((uintmax_t)trailer[1] << 8) | ((uintmax_t)trailer[2] << 16) | ((uintmax_t)trailer[3] << 24);
+
+        // deflate can't do better than ~1032:1, anything above that is a broken or hostile file
+        return std::min(isize, gzSize * 1032);
+    }
+
+    //
+    // zlib's own read buffer. The default (8 KiB) means a syscall for every 8 KiB of compressed input.
+    //
+    constexpr unsigned int GZ_READ_BUFFER_SIZE = 256 * 1024;
+
+    //
+    // zlib backend, gzread/deflate based
+    //
+    class ZlibBackend : public GzBackend
+    {
+    public:
+        const char* name() const override
+        {
+            return "zlib";
+        }
+
+        bool extractGzFile(std::filesystem::path gzFilePath, std::vector<uint8_t>& output) override;
+        bool packGzFile(const uint8_t* buffer, uintmax_t size, std::filesystem::path gzFilePath, const GzParams& params) override;
+    };
+
+    bool ZlibBackend::extractGzFile(std::filesystem::path gzFilePath, std::vector<uint8_t>& output)
+    {
+        uintmax_t sizeHint = getInflatedSizeHint(gzFilePath);
+
+        // Open the input file (gzipped file)
+#ifdef _MSC_VER
+        gzFile gzFile = gzopen_w(gzFilePath.wstring().c_str(), "rb");
+#else
+        gzFile gzFile = gzopen(gzFilePath.string().c_str(), "rb");
+#endif
+        if (gzFile == nullptr)
+        {
+            std::string errmsg = "Can't open the gzip file for reading: " + gzFilePath.string();
+            throw std::runtime_error(errmsg);
+            return false;
+        }
+
+        gzbuffer(gzFile, GZ_READ_BUFFER_SIZE);
+
+        const size_t minGrowth = 64 * 1024;
+        size_t outSize = 0;
+
+        // one spare byte, so a correct hint ends with a short read instead of a full one
+        output.clear();
+        output.resize(sizeHint + 1);
+
+        // Read until the end of the gzipped file, growing the output only if the hint was too small
+        int bytesRead;
+        do
+        {
+            if (outSize == output.size())
+                output.resize(outSize + std::max(outSize / 2, minGrowth));
+
+            unsigned int wanted = (unsigned int)std::min<size_t>(output.size() - outSize, INT_MAX);
+            bytesRead = gzread(gzFile, output.data() + outSize, wanted);
+            if (bytesRead > 0)
+                outSize += bytesRead;
+        } while (bytesRead > 0);
+
+        output.resize(outSize);
+
+        // Check for errors or premature end of file
+        if (gzeof(gzFile) == 0)
+        {
+            gzclose(gzFile);
+
+            std::string errmsg = "Can't read gzipped file: " + gzFilePath.string();
+            throw std::runtime_error(errmsg);
+
+            return false;
+        }
+
+        gzclose(gzFile);
+
+        return true;
+    }
+
+    bool ZlibBackend::packGzFile(const uint8_t* buffer, uintmax_t size, std::filesystem::path gzFilePath, const GzParams& params)
+    {
+        GzWriter writer;
+        writer.open(gzFilePath, params);
+        writer.write(buffer, size);
+        writer.finish();
+
+        return true;
+    }
+
+    GzBackend& zlibBackend()
+    {
+        static ZlibBackend backend;
+        return backend;
+    }
+
+    GzBackend& defaultBackend()
+    {
+#ifdef TFSTRING_USE_LIBDEFLATE
+        return libdeflateBackend();
+#else
+        return zlibBackend();
+#endif
+    }
+
+    bool extractGzFile(std::filesystem::path gzFilePath, std::vector<uint8_t>& output)
+    {
+        return defaultBackend().extractGzFile(gzFilePath, output);
+    }
+
+    bool packGzFile(const uint8_t* buffer, uintmax_t size, std::filesystem::path gzFilePath, const GzParams& params)
+    {
+        return defaultBackend().packGzFile(buffer, size, gzFilePath, params);
+    }
+
+    bool extractGzFile(std::filesystem::path gzFilePath, std::filesystem::path outputPath)
+    {
+        std::vector<uint8_t> inflated;
+        extractGzFile(gzFilePath, inflated);
+
+        // Open the output file
+        std::ofstream outputFile(outputPath, std::ios::out | std::ios::binary);
+        if (!outputFile.is_open())
+        {
+            std::string errmsg = "Can't open gzip output file: " + outputPath.string();
+            throw std::runtime_error(errmsg);
+
+            return false;
+        }
+
+        outputFile.write((const char*)inflated.data(), inflated.size());
+        outputFile.close();
+
+        return true;
+    }
+}
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <vector>
+#include <algorithm>
+#include <climits>
 
 #ifdef _MSC_VER
 #ifdef WIN32
@@ -15,93 +18,208 @@
 
 namespace ZLibWrapper
 {
-    bool extractGzFile(std::filesystem::path gzFilePath, std::filesystem::path outputPath)
+    //
+    // Deflate settings for gzip output. The defaults match what gzopen(..., "wb") used to produce.
+    // Levels are zlib's (0-9, -1 = default). The libdeflate backend maps 9 to its own best level (12) and ignores strategy and memLevel.
+    //
+    struct GzParams
     {
-        // Open the input file (gzipped file)
-#ifdef _MSC_VER
-        gzFile gzFile = gzopen_w(gzFilePath.wstring().c_str(), "rb");
-#else
-        gzFile gzFile = gzopen(gzFilePath.string().c_str(), "rb");
-#endif
-        if (gzFile == nullptr)
+        int level = -1;     // Z_DEFAULT_COMPRESSION
+        int strategy = 0;   // Z_DEFAULT_STRATEGY
+        int memLevel = 8;
+
+        // Quickest output, for iteration builds
+        static GzParams fast()
         {
-            std::string errmsg = "Can't open the gzip file for reading: " + gzFilePath.string();
-            throw std::runtime_error(errmsg);
-            return false;
+            GzParams params;
+            params.level = 1;
+            params.memLevel = 9;
+            return params;
         }
 
-        // Open the output file
-        std::ofstream outputFile(outputPath, std::ios::out | std::ios::binary);
-        if (!outputFile.is_open())
+        // Smallest output, for release builds
+        static GzParams best()
         {
-            gzclose(gzFile);
+            GzParams params;
+            params.level = 9;
+            params.memLevel = 9;
+            return params;
+        }
+    };
 
-            std::string errmsg = "Can't open gzip output file: " + outputPath.string();
-            throw std::runtime_error(errmsg);
+    //
+    // A compression backend. They all read and write plain RFC 1952 gzip, so whatever one of them packs
+    // the others (and the game's zlib based loader) read back byte for byte.
+    //
+    class GzBackend
+    {
+    public:
+        virtual ~GzBackend() = default;
+
+        // Short name for logs and the incremental build settings
+        virtual const char* name() const = 0;
+
+        // Decompresses a gzipped file into memory. Multiple members and trailing garbage are handled like gzread does,
+        // a file that isn't gzipped at all is passed through as-is.
+        virtual bool extractGzFile(std::filesystem::path gzFilePath, std::vector<uint8_t>& output) = 0;
+
+        // Compresses a buffer into a gzip file
+        virtual bool packGzFile(const uint8_t* buffer, uintmax_t size, std::filesystem::path gzFilePath, const GzParams& params) = 0;
+    };
+
+    //
+    // zlib, always built in
+    //
+    GzBackend& zlibBackend();
+
+#ifdef TFSTRING_USE_LIBDEFLATE
+    //
+    // libdeflate, only works on whole buffers (which is all we need since every file fits in memory)
+    //
+    GzBackend& libdeflateBackend();
+#endif
 
-            return false;
-        }
+    //
+    // The backend chosen at configure time: libdeflate with TFSTRING_USE_LIBDEFLATE, zlib otherwise.
+    // The free functions below go through it.
+    //
+    GzBackend& defaultBackend();
+
+    //
+    // Guesses the decompressed size of a gzip file from its ISIZE trailer (the last 4 bytes, size mod 2^32).
+    // Only the last member is described by it and the file might lie, so this is just a starting size.
+    // Returns 0 if there's nothing usable.
+    //
+    uintmax_t getInflatedSizeHint(const uint8_t* gzData, uintmax_t gzSize);
+
+    uintmax_t getInflatedSizeHint(std::filesystem::path gzFilePath);
+
+    //
+    // Decompresses a gzipped file straight into memory, with the default backend.
+    // The output is allocated once from the ISIZE trailer. Multiple members and trailing garbage are handled like gzread does.
+    //
+    bool extractGzFile(std::filesystem::path gzFilePath, std::vector<uint8_t>& output);
+
+    //
+    // Decompresses a gzipped file into another file
+    //
+    bool extractGzFile(std::filesystem::path gzFilePath, std::filesystem::path outputPath);
+
+    //
+    // Compresses a buffer into a gzip file, with the default backend
+    //
+    bool packGzFile(const uint8_t* buffer, uintmax_t size, std::filesystem::path gzFilePath, const GzParams& params = GzParams());
+
+    //
+    // Streams data through deflate into a gzip file. Data can be fed in any number of pieces with write(),
+    // finish() flushes the rest and writes the gzip trailer. Throws on failure.
+    // This is always zlib, libdeflate can't stream.
+    //
+    class GzWriter
+    {
+    private:
+        static constexpr size_t OUT_CHUNK_SIZE = 256 * 1024;
 
-        const int bufferSize = 1024;
-        char buffer[bufferSize];
+        z_stream strm;
+        bool bStreamInit;
+        std::ofstream ofile;
+        std::filesystem::path filePath;
+        std::vector<uint8_t> outbuf;
 
-        // Read and write data until the end of the gzipped file
-        int bytesRead;
-        while ((bytesRead = gzread(gzFile, buffer, bufferSize)) > 0)
+        void deflateChunk(const uint8_t* data, uintmax_t size, int flush)
         {
-            outputFile.write(buffer, bytesRead);
+            // avail_in is only 32 bits wide, so huge inputs go in slices
+            do
+            {
+                uInt slice = (uInt)std::min<uintmax_t>(size, UINT32_MAX);
+                strm.next_in = (Bytef*)data;
+                strm.avail_in = slice;
+                data += slice;
+                size -= slice;
+
+                int sliceFlush = size ? Z_NO_FLUSH : flush;
+                int ret;
+                do
+                {
+                    strm.next_out = outbuf.data();
+                    strm.avail_out = (uInt)outbuf.size();
+
+                    ret = deflate(&strm, sliceFlush);
+                    if (ret == Z_STREAM_ERROR)
+                    {
+                        std::string errmsg = "Failed to compress data for: " + filePath.string();
+                        throw std::runtime_error(errmsg);
+                    }
+
+                    ofile.write((const char*)outbuf.data(), outbuf.size() - strm.avail_out);
+                    if (!ofile)
+                    {
+                        std::string errmsg = "Failed to write data to: " + filePath.string();
+                        throw std::runtime_error(errmsg);
+                    }
+                } while ((strm.avail_out == 0) || ((sliceFlush == Z_FINISH) && (ret != Z_STREAM_END)));
+            } while (size);
         }
 
-        // Check for errors or premature end of file
-        if (gzeof(gzFile) == 0)
+    public:
+        void open(std::filesystem::path gzFilePath, const GzParams& params = GzParams())
         {
-            gzclose(gzFile);
-            outputFile.close();
-
-            std::string errmsg = "Can't read gzipped file: " + gzFilePath.string();
-            throw std::runtime_error(errmsg);
-            
-            return false;
+            filePath = gzFilePath;
+
+            ofile.open(gzFilePath, std::ios::out | std::ios::binary);
+            if (!ofile.is_open())
+            {
+                std::string errmsg = "Can't open a gzip file for writing: " + gzFilePath.string();
+                throw std::runtime_error(errmsg);
+            }
+
+            // 15 bit window + 16 = write a gzip header and trailer instead of a zlib one
+            if (deflateInit2(&strm, params.level, Z_DEFLATED, 15 + 16, params.memLevel, params.strategy) != Z_OK)
+            {
+                std::string errmsg = "Can't initialize the compressor for: " + gzFilePath.string();
+                throw std::runtime_error(errmsg);
+            }
+            bStreamInit = true;
+
+            outbuf.resize(OUT_CHUNK_SIZE);
         }
 
-        // Close the input and output files
-        gzclose(gzFile);
-        outputFile.close();
-
-        return true;
-    }
-
-    bool packGzFile(const uint8_t* buffer, uintmax_t size, std::filesystem::path gzFilePath)
-    {
-#ifdef _MSC_VER
-        gzFile file = gzopen_w(gzFilePath.wstring().c_str(), "wb");
-#else
-        gzFile file = gzopen(gzFilePath.string().c_str(), "wb");
-#endif
-        if (file == nullptr)
+        void write(const void* data, uintmax_t size)
         {
-            std::string errmsg = "Can't open a gzip file for writing: " + gzFilePath.string();
-            throw std::runtime_error(errmsg);
-
-            return false;
+            if (size)
+                deflateChunk((const uint8_t*)data, size, Z_NO_FLUSH);
         }
 
-        int result = gzwrite(file, buffer, size);
-
-        if (result <= 0)
+        void finish()
         {
-            gzclose(file);
+            deflateChunk(nullptr, 0, Z_FINISH);
 
-            std::string errmsg = "Failed to write data to: " + gzFilePath.string();
-            throw std::runtime_error(errmsg);
+            deflateEnd(&strm);
+            bStreamInit = false;
 
-            return false;
+            ofile.close();
+            if (ofile.fail())
+            {
+                std::string errmsg = "Failed to write data to: " + filePath.string();
+                throw std::runtime_error(errmsg);
+            }
         }
 
-        gzclose(file);
+        GzWriter()
+        {
+            strm = {};
+            bStreamInit = false;
+        }
+
+        GzWriter(const GzWriter&) = delete;
+        GzWriter& operator=(const GzWriter&) = delete;
 
-        return true;
-    }
+        ~GzWriter()
+        {
+            if (bStreamInit)
+                deflateEnd(&strm);
+        }
+    };
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#
+# Round trips through the TagForceString command line on the fixtures in tests/fixtures (UTF-8 mode, so they stay readable):
+#   - strtbl with --tail-merge: a suffix string, an exact duplicate, and the alias export of both
+#   - alias sections pointing at a later section and alias chains, resolved on import and exported back
+#   - txt2fold --incremental: a rerun and a touched (same content) input skip, editing one input rebuilds just that file
+#
+# cmake -DTFSTRING=<TagForceString binary> -DFIXTURES=<tests/fixtures> -DWORK=<scratch folder> -P CliRoundTrip.cmake
+#
+cmake_minimum_required(VERSION 3.16)
+
+foreach(var TFSTRING FIXTURES WORK)
+    if(NOT ${var})
+        message(FATAL_ERROR "${var} isn't set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK}")
+file(MAKE_DIRECTORY "${WORK}")
+
+# Runs TagForceString with the given arguments, it has to succeed. Its console output goes to outVar.
+function(tfstring outVar)
+    execute_process(COMMAND "${TFSTRING}" ${ARGN}
+        WORKING_DIRECTORY "${WORK}"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "TagForceString ${ARGN} failed (${result}):\n${output}")
+    endif()
+    set(${outVar} "${output}" PARENT_SCOPE)
+endfunction()
+
+function(expectSameFile expected actual)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files "${expected}" "${actual}" RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        file(READ "${expected}" expectedText)
+        file(READ "${actual}" actualText)
+        message(FATAL_ERROR "${actual} differs from ${expected}\n--- expected:\n${expectedText}\n--- got:\n${actualText}")
+    endif()
+endfunction()
+
+function(expectOutput output regex what)
+    if(NOT "${output}" MATCHES "${regex}")
+        message(FATAL_ERROR "${what}: '${regex}' not found in the output:\n${output}")
+    endif()
+endfunction()
+
+#
+# strtbl: "a monster" and "face-down" end other strings, [2] and [7] repeat [0] and [3]
+#
+tfstring(output -u txt2bin "${FIXTURES}/strings.txt" strings_plain.bin)
+tfstring(output -u --tail-merge txt2bin "${FIXTURES}/strings.txt" strings_tail.bin)
+expectOutput("${output}" "Tail merging saved [1-9][0-9]* bytes" "txt2bin --tail-merge")
+
+file(SIZE "${WORK}/strings_plain.bin" plainSize)
+file(SIZE "${WORK}/strings_tail.bin" tailSize)
+if(NOT tailSize LESS plainSize)
+    message(FATAL_ERROR "Tail merging didn't make the strtbl smaller (${tailSize} vs ${plainSize} bytes)")
+endif()
+
+tfstring(output -u bin2txt strings_tail.bin strings_tail.txt)
+expectSameFile("${FIXTURES}/strings.txt" "${WORK}/strings_tail.txt")
+
+# the duplicates share their string, the tail merged ones only share its end and keep their own text
+tfstring(output -u --aliases bin2txt strings_tail.bin strings_aliases.txt)
+expectSameFile("${FIXTURES}/strings_aliases.txt" "${WORK}/strings_aliases.txt")
+
+#
+# Aliases: [1] points at the later [3], [2] and [4] only reach it through other aliases
+#
+tfstring(output -u txt2bin "${FIXTURES}/aliases.txt" aliases.bin)
+if("${output}" MATCHES "WARNING")
+    message(FATAL_ERROR "txt2bin couldn't resolve the aliases:\n${output}")
+endif()
+
+tfstring(output -u bin2txt aliases.bin aliases_resolved.txt)
+expectSameFile("${FIXTURES}/aliases_resolved.txt" "${WORK}/aliases_resolved.txt")
+
+tfstring(output -u --aliases bin2txt aliases.bin aliases_export.txt)
+expectSameFile("${FIXTURES}/aliases_export.txt" "${WORK}/aliases_export.txt")
+
+# the exported aliases build the same file again
+tfstring(output -u txt2bin aliases_export.txt aliases_reimport.bin)
+expectSameFile("${WORK}/aliases.bin" "${WORK}/aliases_reimport.bin")
+
+#
+# Folder modes with --incremental. The cache is keyed on content, so only an edit makes a file convert again.
+#
+file(MAKE_DIRECTORY "${WORK}/txt")
+configure_file("${FIXTURES}/strings.txt" "${WORK}/txt/Scr00_e.txt" COPYONLY)
+configure_file("${FIXTURES}/aliases_resolved.txt" "${WORK}/txt/Scr01_e.gz.txt" COPYONLY)
+
+tfstring(output -u -j 2 --tail-merge --incremental txt2fold txt lang)
+expectOutput("${output}" "0 of 2 files were up to date" "first txt2fold --incremental")
+
+tfstring(output -u -j 2 --tail-merge --incremental txt2fold txt lang)
+expectOutput("${output}" "2 of 2 files were up to date" "txt2fold --incremental rerun")
+
+file(TOUCH "${WORK}/txt/Scr00_e.txt" "${WORK}/txt/Scr01_e.gz.txt")
+tfstring(output -u -j 2 --tail-merge --incremental txt2fold txt lang)
+expectOutput("${output}" "2 of 2 files were up to date" "txt2fold --incremental after touching the inputs")
+
+file(APPEND "${WORK}/txt/Scr01_e.gz.txt" "[6]\nDuel!\n")
+tfstring(output -u -j 2 --tail-merge --incremental txt2fold txt lang)
+expectOutput("${output}" "1 of 2 files were up to date" "txt2fold --incremental after editing one input")
+
+# a different setting converts everything again
+tfstring(output -u -j 2 --incremental txt2fold txt lang)
+expectOutput("${output}" "0 of 2 files were up to date" "txt2fold --incremental without --tail-merge")
+tfstring(output -u -j 2 --tail-merge --incremental txt2fold txt lang)
+expectOutput("${output}" "0 of 2 files were up to date" "txt2fold --incremental with --tail-merge again")
+
+tfstring(output -u fold2txt lang txt_back)
+expectSameFile("${WORK}/txt/Scr00_e.txt" "${WORK}/txt_back/Scr00_e.txt")
+expectSameFile("${WORK}/txt/Scr01_e.gz.txt" "${WORK}/txt_back/Scr01_e.gz.txt")
+
+file(REMOVE_RECURSE "${WORK}")
+message(STATUS "All command line round trips match")
@@ -0,0 +1,231 @@
+//
+// Yu-Gi-Oh! Tag Force Language & String Tool
+// by Xan / Tenjoin
+//
+// tfstring_gz_roundtrip: packs data with the configured compression backend and reads it back with zlib, and the other way around.
+// The game's loader is zlib based, so every .bin.gz we write has to be a single plain gzip member that zlib inflates byte for byte.
+//
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdint>
+#include <cstring>
+
+#include "ZlibWrapper.hpp"
+
+namespace GzRoundTrip
+{
+    int failCount = 0;
+
+    void fail(const std::string& what)
+    {
+        std::cerr << "FAILED: " << what << '\n';
+        failCount++;
+    }
+
+    std::vector<uint8_t> readFile(const std::filesystem::path& path)
+    {
+        std::ifstream ifile(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(ifile), std::istreambuf_iterator<char>());
+    }
+
+    //
+    // Inflates exactly one gzip member with zlib's inflate() and nothing else, unlike gzread this doesn't pass
+    // non-gzip data through or skip trailing garbage. This is what the game sees.
+    //
+    bool inflateStrict(const std::vector<uint8_t>& gzData, std::vector<uint8_t>& output)
+    {
+        z_stream strm = {};
+        if (inflateInit2(&strm, 15 + 16) != Z_OK)
+            return false;
+
+        output.clear();
+        uint8_t chunk[64 * 1024];
+        strm.next_in = (Bytef*)gzData.data();
+        strm.avail_in = (uInt)gzData.size();
+
+        int ret;
+        do
+        {
+            strm.next_out = chunk;
+            strm.avail_out = sizeof(chunk);
+            ret = inflate(&strm, Z_NO_FLUSH);
+            output.insert(output.end(), chunk, chunk + (sizeof(chunk) - strm.avail_out));
+        } while (ret == Z_OK);
+
+        bool bWhole = (ret == Z_STREAM_END) && (strm.avail_in == 0);
+        inflateEnd(&strm);
+
+        return bWhole;
+    }
+
+    //
+    // Something like a UTF-16 lang file: lots of repeated words and control codes, plus a stretch of noise
+    //
+    std::vector<uint8_t> makeLangLike(size_t size)
+    {
+        static const char* words[] = { "Summon", "Tribute", "monster", "Spell", "Trap", "Card", "$C", "$R", "Graveyard", "ATK", "DEF", "\n" };
+
+        std::mt19937 rng(1234);
+        std::vector<uint8_t> data;
+        while (data.size() < size)
+        {
+            const char* word = words[rng() % std::size(words)];
+            for (const char* p = word; *p; p++)
+            {
+                data.push_back((uint8_t)*p);
+                data.push_back(0);
+            }
+            data.push_back(' ');
+            data.push_back(0);
+        }
+        data.resize(size);
+
+        for (size_t i = size / 2; i < size / 2 + 4096 && i < size; i++)
+            data[i] = (uint8_t)rng();
+
+        return data;
+    }
+
+    std::vector<uint8_t> makeNoise(size_t size)
+    {
+        std::mt19937 rng(5678);
+        std::vector<uint8_t> data(size);
+        for (uint8_t& b : data)
+            b = (uint8_t)rng();
+
+        return data;
+    }
+
+    void checkPair(ZLibWrapper::GzBackend& packer, ZLibWrapper::GzBackend& reader, const std::string& sampleName, const std::vector<uint8_t>& sample,
+        const std::string& paramsName, const ZLibWrapper::GzParams& params, const std::filesystem::path& workDir)
+    {
+        std::string what = sampleName + " packed by " + packer.name() + " (" + paramsName + "), read by " + reader.name();
+        std::filesystem::path gzPath = workDir / (sampleName + '_' + packer.name() + '_' + paramsName + ".bin.gz");
+
+        try
+        {
+            packer.packGzFile(sample.data(), sample.size(), gzPath, params);
+
+            std::vector<uint8_t> gzData = readFile(gzPath);
+            if ((gzData.size() < 18) || (gzData[0] != 0x1F) || (gzData[1] != 0x8B) || (gzData[2] != Z_DEFLATED))
+            {
+                fail(what + ": not a gzip file");
+                return;
+            }
+
+            uint32_t isize = gzData[gzData.size() - 4] | (gzData[gzData.size() - 3] << 8) | (gzData[gzData.size() - 2] << 16) | ((uint32_t)gzData[gzData.size() - 1] << 24);
+            if (isize != (uint32_t)sample.size())
+                fail(what + ": wrong ISIZE trailer");
+
+            std::vector<uint8_t> strict;
+            if (!inflateStrict(gzData, strict) || (strict != sample))
+                fail(what + ": zlib inflate() doesn't give back the input");
+
+            std::vector<uint8_t> extracted;
+            reader.extractGzFile(gzPath, extracted);
+            if (extracted != sample)
+                fail(what + ": extracted data differs");
+        }
+        catch (const std::exception& e)
+        {
+            fail(what + ": " + e.what());
+        }
+    }
+
+    //
+    // Files with several members are read like gzread does, as the members one after another
+    //
+    void checkMultiMember(const std::vector<uint8_t>& first, const std::vector<uint8_t>& second, const std::filesystem::path& workDir)
+    {
+        ZLibWrapper::GzBackend& configured = ZLibWrapper::defaultBackend();
+        ZLibWrapper::GzBackend& zlib = ZLibWrapper::zlibBackend();
+
+        std::filesystem::path firstPath = workDir / "member1.bin.gz";
+        std::filesystem::path secondPath = workDir / "member2.bin.gz";
+        std::filesystem::path joinedPath = workDir / "members.bin.gz";
+
+        try
+        {
+            configured.packGzFile(first.data(), first.size(), firstPath, ZLibWrapper::GzParams());
+            zlib.packGzFile(second.data(), second.size(), secondPath, ZLibWrapper::GzParams());
+
+            std::vector<uint8_t> joined = readFile(firstPath);
+            std::vector<uint8_t> secondData = readFile(secondPath);
+            joined.insert(joined.end(), secondData.begin(), secondData.end());
+            std::ofstream(joinedPath, std::ios::binary).write((const char*)joined.data(), joined.size());
+
+            std::vector<uint8_t> expected = first;
+            expected.insert(expected.end(), second.begin(), second.end());
+
+            for (ZLibWrapper::GzBackend* reader : { &configured, &zlib })
+            {
+                std::vector<uint8_t> extracted;
+                reader->extractGzFile(joinedPath, extracted);
+                if (extracted != expected)
+                    fail(std::string("two members read by ") + reader->name() + ": extracted data differs");
+            }
+        }
+        catch (const std::exception& e)
+        {
+            fail(std::string("two members: ") + e.what());
+        }
+    }
+
+    int Run(std::filesystem::path workDir)
+    {
+        std::filesystem::create_directories(workDir);
+
+        ZLibWrapper::GzBackend& configured = ZLibWrapper::defaultBackend();
+        ZLibWrapper::GzBackend& zlib = ZLibWrapper::zlibBackend();
+        std::cout << "Configured backend: " << configured.name() << '\n';
+
+        std::vector<std::pair<std::string, std::vector<uint8_t>>> samples =
+        {
+            { "empty", {} },
+            { "short", { 'Y', 0, 'u', 0, '-', 0, 'G', 0, 'i', 0 } },
+            { "lang", makeLangLike(1024 * 1024 + 17) },
+            { "noise", makeNoise(256 * 1024) },
+        };
+
+        std::vector<std::pair<std::string, ZLibWrapper::GzParams>> paramSets =
+        {
+            { "default", ZLibWrapper::GzParams() },
+            { "fast", ZLibWrapper::GzParams::fast() },
+            { "best", ZLibWrapper::GzParams::best() },
+        };
+
+        for (const auto& [sampleName, sample] : samples)
+        {
+            for (const auto& [paramsName, params] : paramSets)
+            {
+                checkPair(configured, zlib, sampleName, sample, paramsName, params, workDir);
+                checkPair(zlib, configured, sampleName, sample, paramsName, params, workDir);
+            }
+        }
+
+        checkMultiMember(samples[2].second, samples[1].second, workDir);
+
+        std::filesystem::remove_all(workDir);
+
+        if (failCount)
+        {
+            std::cerr << failCount << " check(s) failed\n";
+            return 1;
+        }
+
+        std::cout << "All gzip round trips match\n";
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::filesystem::path workDir = (argc > 1) ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path() / "tfstring_gz_roundtrip";
+
+    return GzRoundTrip::Run(workDir);
+}